@@ -3,14 +3,28 @@
 
 #define BOOST_THREAD_VERSION 3
 
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
 #include <boost/function.hpp>
 #include <boost/noncopyable.hpp>
+#include <boost/optional.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/chrono.hpp>
+#include <boost/cstdint.hpp>
 
 #include <boost/thread/thread.hpp>
 #include <boost/thread/future.hpp>
 
 #include "message_queue.h"
+#include "TimerWheel.h"
+#include "ResultCache.h"
+#include "SingleFlight.h"
 
 //-----------------------------------------------------------------------------
 
@@ -88,13 +102,16 @@ struct Dispatcher
     {
         R r = exec( m );
         pr->set_value( r );
-        p->send( r );
+        if( p )
+            p->send( r );
     }
 
     template< typename M >
     void operator() ( typename IActive<R>::Ptr p, boost::function< R ( M ) > exec, M m )
     {
-        p->send( exec( m ) );
+        R r = exec( m );
+        if( p )
+            p->send( r );
     }
 };
 
@@ -108,6 +125,7 @@ struct Dispatcher<void>
     void operator() ( typename IActive<void>::Ptr p, boost::function< void ( M ) > exec, M m, promise_t pr )
     {
         exec( m );
+        pr->set_value();
     }
 
     template< typename M >
@@ -117,12 +135,184 @@ struct Dispatcher<void>
     }
 };
 
+/// Executes a message once and fulfills several promises with the result
+template < typename R >
+struct Fanout
+{
+    typedef void result_type;
+    typedef boost::shared_ptr< boost::promise<R> > promise_t;
+
+    template< typename M >
+    void operator() ( typename IActive<R>::Ptr p, boost::function< R ( M ) > exec, M m, const std::vector<promise_t>& prs )
+    {
+        boost::optional<R> r;
+        try
+        {
+            r = exec( m );
+        }
+        catch(...)
+        {
+            if( prs.empty() )
+                throw;
+            for( size_t i = 0; i < prs.size(); ++i )
+                prs[i]->set_exception( boost::current_exception() );
+            return;
+        }
+        for( size_t i = 0; i < prs.size(); ++i )
+            prs[i]->set_value( *r );
+        if( p )
+            p->send( *r );
+    }
+
+    /// Collects the promises only after executing, so those attached meanwhile also get the result
+    template< typename M >
+    void operator() ( typename IActive<R>::Ptr p, boost::function< R ( M ) > exec, M m, boost::function< std::vector<promise_t> () > collect )
+    {
+        boost::optional<R> r;
+        try
+        {
+            r = exec( m );
+        }
+        catch(...)
+        {
+            std::vector<promise_t> prs = collect();
+            if( prs.empty() )
+                throw;
+            for( size_t i = 0; i < prs.size(); ++i )
+                prs[i]->set_exception( boost::current_exception() );
+            return;
+        }
+        std::vector<promise_t> prs = collect();
+        for( size_t i = 0; i < prs.size(); ++i )
+            prs[i]->set_value( *r );
+        if( p )
+            p->send( *r );
+    }
+};
+
+template <>
+struct Fanout<void>
+{
+    typedef void result_type;
+    typedef boost::shared_ptr< boost::promise<void> > promise_t;
+
+    template< typename M >
+    void operator() ( typename IActive<void>::Ptr p, boost::function< void ( M ) > exec, M m, const std::vector<promise_t>& prs )
+    {
+        try
+        {
+            exec( m );
+        }
+        catch(...)
+        {
+            if( prs.empty() )
+                throw;
+            for( size_t i = 0; i < prs.size(); ++i )
+                prs[i]->set_exception( boost::current_exception() );
+            return;
+        }
+        for( size_t i = 0; i < prs.size(); ++i )
+            prs[i]->set_value();
+    }
+
+    template< typename M >
+    void operator() ( typename IActive<void>::Ptr p, boost::function< void ( M ) > exec, M m, boost::function< std::vector<promise_t> () > collect )
+    {
+        try
+        {
+            exec( m );
+        }
+        catch(...)
+        {
+            std::vector<promise_t> prs = collect();
+            if( prs.empty() )
+                throw;
+            for( size_t i = 0; i < prs.size(); ++i )
+                prs[i]->set_exception( boost::current_exception() );
+            return;
+        }
+        std::vector<promise_t> prs = collect();
+        for( size_t i = 0; i < prs.size(); ++i )
+            prs[i]->set_value();
+    }
+};
+
+/// Answers a message from a result cache
+template < typename M, typename R >
+struct Memo
+{
+    typedef bool result_type;
+
+    /// @returns true on a cache hit, after completing the promise and feeding the pipe
+    bool operator() ( boost::shared_ptr< ResultCache<M,R> > c, const M& m,
+                      typename IActive<R>::Ptr p, boost::shared_ptr< boost::promise<R> > pr ) const
+    {
+        R r;
+        if( !c->get( m, r ) )
+            return false;
+        if( pr )
+            pr->set_value( r );
+        if( p )
+            p->send( r );
+        return true;
+    }
+};
+
+/// Boards a message on the flight of an identical one, or starts a new flight
+template < typename M, typename R >
+struct Board
+{
+    typedef bool result_type;
+    typedef boost::shared_ptr< boost::promise<R> > promise_t;
+    typedef boost::function< void () > work_t;
+
+    /// @returns true if the message joined a flight already in the air, else the work and abort of the new flight
+    bool operator() ( boost::shared_ptr< SingleFlight<M,R> > f, const M& m, typename IActive<R>::Ptr p,
+                      boost::function< R ( M ) > exec, promise_t pr, work_t& w, work_t& abort ) const
+    {
+        if( !f->join( m, pr ) )
+            return true;
+
+        boost::function< std::vector<promise_t> () > land = boost::bind( &SingleFlight<M,R>::land, f, m );
+
+        w     = boost::bind( Fanout<R>(), p, exec, m, land );
+        abort = boost::bind( &SingleFlight<M,R>::abort, f, m );
+        return false;
+    }
+};
+
 }
 
 //-----------------------------------------------------------------------------
 
+/// Counters describing the activity of an Active object
+struct ActiveStats
+{
+    ActiveStats() : processed(0), dropped(0), cache_hits(0), cache_misses(0), shared(0), busy(0) {}
+
+    size_t                     processed;     ///< nb of messages executed
+    size_t                     dropped;       ///< nb of messages refused or discarded by the admission policy
+    size_t                     cache_hits;    ///< nb of messages answered by the result cache
+    size_t                     cache_misses;  ///< nb of messages the result cache could not answer
+    size_t                     shared;        ///< nb of messages that shared the execution of an identical one in flight
+    boost::chrono::nanoseconds busy;          ///< time spent by all threads executing messages
+};
+
+/// State of a worker thread of an Active object, as seen by a watchdog
+struct WorkerState
+{
+    WorkerState() : beats(0) {}
+
+    boost::thread::id                         id;
+    boost::chrono::steady_clock::time_point   busy_since;  ///< start of the current message, zero when idle
+    size_t                                    beats;       ///< nb messages started, the heartbeat
+};
+
+//-----------------------------------------------------------------------------
+
 template < typename M, typename R >
-class Active : public IActive<M> {
+class Active : public IActive<M>,
+               public boost::enable_shared_from_this< Active<M,R> > {
 
 public: // types
 
@@ -145,12 +335,39 @@ protected: // types
 
     typedef boost::function< void () > work_type;
 
+    /// Queued work, with the promise to break if the admission policy discards it
+    struct task
+    {
+        task() {}
+        task( const work_type& w, const promise_ptr& p = promise_ptr(), const work_type& a = work_type() ) :
+            work(w), promise(p), abort(a) {}
+
+        work_type   work;
+        promise_ptr promise;
+        work_type   abort;    ///< breaks the promises instead, if set
+    };
+
     typedef boost::shared_ptr< boost::thread > thread_ptr;
 
     typedef std::map< boost::thread::id, thread_ptr > ThreadPool;
 
     typedef typename detail::Dispatcher<result_type> dispatcher_type;
 
+    typedef boost::function< bool ( const message_type&, pipe_type, promise_ptr ) > lookup_type;
+
+    typedef boost::function< bool ( const message_type&, pipe_type, execution_type, promise_ptr, work_type&, work_type& ) > board_type;
+
+    /// Heartbeat of one worker thread, written by it without locking
+    struct worker_slot
+    {
+        worker_slot() : busy_since(0), beats(0) {}
+
+        boost::atomic<boost::int64_t>  busy_since;  ///< start of the current message in ns of the steady clock, 0 when idle
+        boost::atomic<size_t>          beats;       ///< nb messages started
+    };
+
+    typedef boost::shared_ptr< worker_slot > slot_ptr;
+
 protected: // data
 
     mutable boost::mutex      m_;             ///< mutex for locking changes in the Active object itself
@@ -160,13 +377,34 @@ protected: // data
     execution_type            exec_;          ///< function to handle each message
 
     ThreadPool                threads_;       ///< multiple threads object
+    ThreadPool                retired_;       ///< threads that left the pool and need to be joined
+    boost::atomic<size_t>     retiring_;      ///< nb threads asked to leave the pool, read without the lock
+
+    boost::atomic<size_t>         processed_; ///< nb messages executed
+    boost::atomic<boost::int64_t> busy_;      ///< ns spent by all threads executing messages
+    boost::atomic<size_t>         executing_; ///< nb messages being executed right now
+
+    std::map< boost::thread::id, slot_ptr > workers_; ///< heartbeats of the worker threads, the map under m_
 
-    message_queue<work_type>  mq_;            ///< message queue
+    std::string               name_;          ///< identifies the object in reports
+
+    message_queue<task>       mq_;            ///< message queue
 
     dispatcher_type           dispatch_;      ///< dispatcher of tasks
 
     pipe_type                 pipe_;          ///< possible holds a pipe
 
+    TimerWheel::Ptr           timers_;        ///< timer service for delayed messages
+
+    boost::shared_ptr<CacheCounters> cache_;  ///< result cache, if any
+    lookup_type               lookup_;        ///< answers messages from the result cache
+    execution_type            memo_exec_;     ///< exec_ filling the result cache
+
+    boost::shared_ptr<FlightCounters> flights_; ///< requests in flight, if single flight is enabled
+    board_type                board_;         ///< joins messages to identical ones in flight
+
+    boost::atomic<bool>       plain_;         ///< neither cache nor single flight, sends skip the lock
+
 public: // methods
 
     /// Constructor
@@ -176,10 +414,17 @@ public: // methods
             size_t qsize = 0 ) :
         done_(false),
         exec_(x),
+        retiring_(0),
+        processed_(0),
+        busy_(0),
+        executing_(0),
         mq_(qsize),
         dispatch_(),
-        pipe_()
+        pipe_(),
+        timers_(),
+        plain_(true)
     {
+        mq_.on_drop( &Active<M,R>::dropped );
         spawn_threads(nb_threads);
     }
 
@@ -190,8 +435,16 @@ public: // methods
         mq_.drain_and_close();
         done_ = true;
 
+        ThreadPool threads;
+        {
+            boost::lock_guard<boost::mutex> lock(m_);
+            threads.swap( threads_ );
+            threads.insert( retired_.begin(), retired_.end() );
+            retired_.clear();
+        }
+
         // wait for all threads still processing queue messages to exit normally
-        for( ThreadPool::iterator i = threads_.begin(); i != threads_.end(); ++i )
+        for( ThreadPool::iterator i = threads.begin(); i != threads.end(); ++i )
             if( i->second->joinable() )
                 i->second->join();
     }
@@ -199,13 +452,12 @@ public: // methods
     /// Enqueue a message
     virtual void send( message_type msg )
     {
-        boost::unique_lock<boost::mutex> lock(m_);
-
-        work_type w = boost::bind( dispatch_, pipe_, exec_, msg );
+        work_type w;
 
-        lock.unlock();
+        if( prepare( msg, promise_ptr(), w ) )
+            return;
 
-        if( ! mq_.wait_and_push( w ) )
+        if( ! mq_.wait_and_push( task(w) ) )
             throw Active<M,R>::Exception();
     }
 
@@ -213,35 +465,247 @@ public: // methods
     /// @returns on promise passed from outsides
     virtual void send( message_type msg, promise_ptr p )
     {
-        boost::unique_lock<boost::mutex> lock(m_);
-
-        work_type w = boost::bind( dispatch_, pipe_, exec_, msg, p );
+        work_type w;
+        work_type a;
 
-        lock.unlock();
+        if( prepare( msg, p, w, a ) )
+            return;
 
-        if( ! mq_.wait_and_push( w ) )
+        if( ! mq_.wait_and_push( task(w,p,a) ) )
+        {
+            if( a )
+                a();
             throw Active<M,R>::Exception();
+        }
+    }
+
+    /// Enqueues a message if the admission policy allows it, never blocks
+    /// @returns ADMITTED or the reason the message was rejected
+    admission_status try_send( message_type msg )
+    {
+        work_type w;
+
+        if( prepare( msg, promise_ptr(), w ) )
+            return ADMITTED;
+
+        return mq_.try_push( task(w) );
+    }
+
+    /// Enqueues a message if the admission policy allows it, never blocks
+    /// If the message is later discarded (DROP_OLDEST) the promise holds an Exception
+    /// @returns ADMITTED or the reason the message was rejected, then the promise is left untouched
+    ///          unless it led a single flight, then all promises of the flight hold an Exception
+    admission_status try_send( message_type msg, promise_ptr p )
+    {
+        work_type w;
+        work_type a;
+
+        if( prepare( msg, p, w, a ) )
+            return ADMITTED;
+
+        admission_status s = mq_.try_push( task(w,p,a) );
+        if( s != ADMITTED && a )
+            a();
+        return s;
+    }
+
+    /// Sets the admission policy for try_send
+    void admission( const admission_policy& p ) { mq_.admission(p); }
+
+    /// @returns the admission decisions of try_send
+    admission_counters admission() const { return mq_.counters(); }
+
+    /// Memoizes results in a cache, hits complete the promise without entering the queue
+    /// Only meant for pure execution functions; an empty pointer disables the cache
+    void cache( const boost::shared_ptr< ResultCache<M,R> >& c )
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+
+        cache_ = c;
+
+        if( c )
+        {
+            lookup_    = boost::bind( detail::Memo<M,R>(), c, _1, _2, _3 );
+            memo_exec_ = boost::bind( &ResultCache<M,R>::compute, c, exec_, _1 );
+        }
+        else
+        {
+            lookup_.clear();
+            memo_exec_.clear();
+        }
+
+        plain_ = !cache_ && !flights_;
+    }
+
+    /// Shares one execution among identical messages sent with a promise while one is in flight
+    /// The first message is queued, the later ones only wait for its result; requires boost::hash<M>
+    /// Only meant for pure execution functions; messages sent without promise are never shared
+    void single_flight( bool on )
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+
+        if( on )
+        {
+            typename SingleFlight<M,R>::Ptr f = SingleFlight<M,R>::create();
+            flights_ = f;
+            board_   = boost::bind( detail::Board<M,R>(), f, _1, _2, _3, _4, _5, _6 );
+        }
+        else
+        {
+            flights_.reset();
+            board_.clear();
+        }
+
+        plain_ = !cache_ && !flights_;
+    }
+
+    /// Enqueues a message once the delay has passed, without blocking any thread meanwhile
+    /// The message goes through try_send, so the shared timer thread never waits on a full
+    /// queue: a rejected delivery is counted in admission(). The pending timer only holds a
+    /// weak reference, so the object must be owned by a Ptr (see create) and timers still
+    /// pending when it is destroyed deliver nothing.
+    /// @returns the id to cancel the delivery
+    TimerWheel::TimerId send_after( TimerWheel::duration d, message_type msg )
+    {
+        return timers()->schedule_after( d, deliver(msg) );
+    }
+
+    /// Enqueues a message at a point in time, without blocking any thread meanwhile
+    /// @returns the id to cancel the delivery
+    TimerWheel::TimerId send_at( TimerWheel::time_point t, message_type msg )
+    {
+        return timers()->schedule_at( t, deliver(msg) );
+    }
+
+    /// Cancels a delayed message
+    /// @returns true if message was cancelled before being enqueued
+    bool cancel( TimerWheel::TimerId id ) { return timers()->cancel(id); }
+
+    /// @returns the timer service for delayed messages, by default the shared one
+    TimerWheel::Ptr timers()
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        if( !timers_ )
+            timers_ = TimerWheel::instance();
+        return timers_;
+    }
+
+    /// Sets the timer service for delayed messages
+    void timers( const TimerWheel::Ptr& t )
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        timers_ = t;
     }
 
     void pipe( const pipe_type& p )
     {
         boost::lock_guard<boost::mutex> lock(m_);
-        return pipe_.reset(p);
+        boost::atomic_store( &pipe_, p ); // also read without the lock by plain sends
+    }
+
+    /// Adds one more worker thread
+    void add_thread()
+    {
+        reap();
+        if( mq_.is_open() ) //< only add if queue is open, else don't bother
+            spawn_threads(1);
+    }
+
+    /// Asks one worker thread to leave once it finishes its current message
+    /// The last thread is never removed
+    /// @returns true if a thread will be removed
+    bool remove_thread()
+    {
+        reap();
+        boost::lock_guard<boost::mutex> lock(m_);
+        if( threads_.size() - retiring_ <= 1 )
+            return false;
+        ++retiring_;
+        return true;
     }
 
     /// @returns the nb worker threads
     size_t tsize()
     {
         boost::lock_guard<boost::mutex> lock(m_);
-        return threads_.size();
+        return threads_.size() - retiring_;
+    }
+
+    /// @returns the name identifying the object in reports
+    std::string name() const
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        return name_;
+    }
+
+    /// Sets the name identifying the object in reports
+    void name( const std::string& n )
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        name_ = n;
+    }
+
+    /// @returns the state of each worker thread
+    std::vector< WorkerState > workers() const
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        std::vector< WorkerState > ws;
+        for( typename std::map< boost::thread::id, slot_ptr >::const_iterator i = workers_.begin(); i != workers_.end(); ++i )
+        {
+            WorkerState w;
+            w.id    = i->first;
+            w.beats = i->second->beats.load( boost::memory_order_relaxed );
+            if( boost::int64_t since = i->second->busy_since.load( boost::memory_order_relaxed ) )
+                w.busy_since += boost::chrono::nanoseconds( since );
+            ws.push_back( w );
+        }
+        return ws;
+    }
+
+    /// @returns the activity counters
+    ActiveStats stats() const
+    {
+        ActiveStats s;
+        s.processed = processed_.load( boost::memory_order_acquire );
+        s.busy      = boost::chrono::nanoseconds( busy_.load( boost::memory_order_relaxed ) );
+
+        boost::shared_ptr<CacheCounters> c;
+        boost::shared_ptr<FlightCounters> f;
+        {
+            boost::lock_guard<boost::mutex> lock(m_);
+            c = cache_;
+            f = flights_;
+        }
+        s.dropped = mq_.counters().dropped();
+        if( c )
+        {
+            s.cache_hits   = c->hits();
+            s.cache_misses = c->misses();
+        }
+        if( f )
+            s.shared = f->joined();
+        return s;
     }
 
     /// @returns the current queue size
     size_t qsize() { return mq_.size(); }
 
+    /// @returns the nb of messages queued or being executed
+    size_t outstanding()
+    {
+        size_t q = mq_.size();
+        return q + executing_.load( boost::memory_order_acquire );
+    }
+
     /// sets the maximum queue size
     void qsize( const size_t& s ) { mq_.max_size(s); }
 
+    /// @returns the maximum queue size, 0 is unlimited
+    size_t max_qsize() const { return mq_.max_size(); }
+
+    /// @returns the nb of senders blocked on a full queue
+    size_t blocked() const { return mq_.blocked(); }
+
     /// Factory method
     static Active<M,R>::Ptr create( execution_type x, size_t nb_threads = 1, size_t qsize = 0 )
     {
@@ -250,6 +714,83 @@ public: // methods
 
 protected: // methods
 
+    /// Breaks the promise of a message discarded by the admission policy
+    static void dropped( task& t )
+    {
+        if( t.abort )
+            t.abort();
+        else if( t.promise )
+            t.promise->set_exception( boost::copy_exception( Active<M,R>::Exception() ) );
+    }
+
+    /// Answers a message from the result cache, or else prepares its work
+    /// @returns true if the message was answered from the cache
+    bool prepare( const message_type& msg, const promise_ptr& p, work_type& w )
+    {
+        work_type a;
+        return prepare( msg, p, w, a );
+    }
+
+    /// Answers a message from the result cache or joins it to an identical one in flight,
+    /// or else prepares its work and, if it leads a new flight, how to abort it
+    /// @returns true if the message needs no work of its own
+    bool prepare( const message_type& msg, const promise_ptr& p, work_type& w, work_type& a )
+    {
+        if( plain_.load( boost::memory_order_acquire ) ) // fast path, exec_ never changes
+        {
+            pipe_type pipe = boost::atomic_load( &pipe_ );
+            if( p )
+                w = boost::bind( dispatch_, pipe, exec_, msg, p );
+            else
+                w = boost::bind( dispatch_, pipe, exec_, msg );
+            return false;
+        }
+
+        boost::unique_lock<boost::mutex> lock(m_);
+
+        pipe_type      pipe   = pipe_;
+        lookup_type    lookup = lookup_;
+        board_type     board  = board_;
+        execution_type exec   = memo_exec_ ? memo_exec_ : exec_;
+
+        lock.unlock(); // unlock here, the pipe may block
+
+        if( lookup && lookup( msg, pipe, p ) )
+            return true;
+
+        if( p && board )
+            return board( msg, pipe, exec, p, w, a );
+
+        if( p )
+            w = boost::bind( dispatch_, pipe, exec, msg, p );
+        else
+            w = boost::bind( dispatch_, pipe, exec, msg );
+
+        return false;
+    }
+
+    /// @returns the work for the timer to enqueue a message
+    TimerWheel::callback_type deliver( message_type msg )
+    {
+        return boost::bind( &Active<M,R>::delivered, boost::weak_ptr< Active<M,R> >( this->shared_from_this() ), msg );
+    }
+
+    /// Runs on the timer thread, so it must neither block nor destroy the object
+    static void delivered( const boost::weak_ptr< Active<M,R> >& w, message_type msg )
+    {
+        Ptr a = w.lock();
+        if( !a )
+            return; // destroyed meanwhile
+
+        a->try_send( msg );
+
+        // the last reference went meanwhile: the destructor drains and joins, not here
+        if( a.unique() )
+            boost::thread( boost::bind( &Active<M,R>::release, a ) ).detach();
+    }
+
+    static void release( Ptr ) {}
+
     void spawn_threads( size_t nb_threads )
     {
         boost::lock_guard<boost::mutex> lock(m_);
@@ -267,19 +808,91 @@ protected: // methods
         }
     }
 
+    /// Joins the threads that left the pool, so they do not linger until destruction
+    void reap()
+    {
+        ThreadPool retired;
+        {
+            boost::lock_guard<boost::mutex> lock(m_);
+            retired.swap( retired_ );
+        }
+
+        // unlocked, the exiting threads still take the lock on their way out
+        for( typename ThreadPool::iterator i = retired.begin(); i != retired.end(); ++i )
+            if( i->second->joinable() )
+                i->second->join();
+    }
+
+    /// Moves the calling thread out of the pool if threads were asked to leave
+    /// @returns true if the calling thread must exit
+    bool retire()
+    {
+        if( !retiring_.load( boost::memory_order_relaxed ) ) // idle workers spin here, avoid the lock
+            return false;
+
+        boost::lock_guard<boost::mutex> lock(m_);
+
+        if( !retiring_ )
+            return false;
+
+        typename ThreadPool::iterator itr = threads_.find( boost::this_thread::get_id() );
+        if( itr == threads_.end() )
+            return false;
+
+        retired_.insert( *itr );
+        threads_.erase( itr );
+        --retiring_;
+
+        return true;
+    }
+
     virtual void run()
     {
         // std::cout << "> starting run()\n" << std::flush;
 
-        work_type w;
+        typedef boost::chrono::steady_clock clock;
+
+        const boost::thread::id id = boost::this_thread::get_id();
+        slot_ptr slot( new worker_slot() );
+        {
+            boost::lock_guard<boost::mutex> lock(m_);
+            workers_[id] = slot;
+        }
+
+        task t;
+        clock::time_point last; // end of the previous message, if popped right after it
         while (!done_)
         {
             try
             {
-                if( mq_.try_and_pop(w) )
-                    w();
+                if( retire() )
+                    break; //< left the pool, will be joined in retired_
+
+                if( mq_.try_and_pop(t) )
+                {
+                    // back to back messages share a clock read, the pop counting as busy
+                    clock::time_point start = last == clock::time_point() ? clock::now() : last;
+
+                    executing_.fetch_add( 1, boost::memory_order_relaxed );
+                    slot->busy_since.store( boost::chrono::duration_cast<boost::chrono::nanoseconds>( start.time_since_epoch() ).count(),
+                                            boost::memory_order_relaxed );
+                    slot->beats.fetch_add( 1, boost::memory_order_relaxed );
+
+                    t.work();
+
+                    last = clock::now();
+
+                    slot->busy_since.store( 0, boost::memory_order_relaxed );
+                    busy_.fetch_add( boost::chrono::duration_cast<boost::chrono::nanoseconds>( last - start ).count(),
+                                     boost::memory_order_relaxed );
+                    processed_.fetch_add( 1, boost::memory_order_release );
+                    executing_.fetch_sub( 1, boost::memory_order_release ); // after processed_, so outstanding() == 0 means counted
+                }
                 else
+                {
+                    last = clock::time_point();
                     boost::this_thread::yield();
+                }
             }
             catch ( boost::thread_interrupted& e )
             {
@@ -288,6 +901,11 @@ protected: // methods
             }
         }
 
+        {
+            boost::lock_guard<boost::mutex> lock(m_);
+            workers_.erase(id);
+        }
+
         //    std::cout << "> ending run()" << std::flush;
     }
 
@@ -296,8 +914,9 @@ protected: // methods
 //-----------------------------------------------------------------------------
 
 /// Operator to pipe Active objects to other Active objects
+/// @returns the sink, so that pipes can be chained as a | b | c
 template< typename T1, typename T2 >
-typename IActive<typename T2::message_type>::Ptr
+boost::shared_ptr<T2>
 operator| ( boost::shared_ptr<T1> source, boost::shared_ptr<T2> sink )
 {
     typedef Pipe< typename T2::message_type > pipe_t;
@@ -308,7 +927,7 @@ operator| ( boost::shared_ptr<T1> source, boost::shared_ptr<T2> sink )
     typename T1::pipe_type p ( pp );
     source->pipe( p );
 
-    return boost::dynamic_pointer_cast< typename IActive<typename T2::message_type>::Ptr >(sink);
+    return sink;
 }
 
 //-----------------------------------------------------------------------------
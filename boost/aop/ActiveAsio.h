@@ -0,0 +1,236 @@
+#ifndef ActiveAsio_h
+#define ActiveAsio_h
+
+#define BOOST_THREAD_VERSION 3
+
+#include <boost/asio.hpp>
+#include <boost/bind.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/exception_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "Active.h"
+
+//-----------------------------------------------------------------------------
+
+/// Active object driven by a boost::asio::io_service
+///
+/// Owns no threads nor queue: each message is posted to the io_service,
+/// through a strand when the object needs serialized access.
+/// I/O completion handlers and messages are then run by the same threads.
+/// Posted messages hold a reference, so the object must be owned by a Ptr (see create)
+/// and may be released anywhere, even by a handler on a single io_service thread.
+/// A handler exception goes to the promise of the message, or is counted in failed(),
+/// never out of io_service::run.
+
+template < typename M, typename R >
+class AsioActive : public IActive<M>,
+                   public boost::enable_shared_from_this< AsioActive<M,R> > {
+
+public: // types
+
+    typedef boost::shared_ptr< AsioActive<M,R> > Ptr;
+
+    typedef M message_type;
+    typedef R result_type;
+
+    typedef typename boost::promise<result_type>         promise_type;
+    typedef typename boost::shared_ptr< promise_type >   promise_ptr;
+    typedef typename boost::future<result_type>          future_type;
+
+    typedef boost::function< result_type ( message_type ) > execution_type;
+
+    typedef typename IActive<result_type>::Ptr  pipe_type;
+
+protected: // types
+
+    typedef boost::function< void () > work_type;
+
+    typedef typename detail::Dispatcher<result_type> dispatcher_type;
+
+protected: // data
+
+    mutable boost::mutex      m_;             ///< mutex for locking changes in the Active object itself
+
+    boost::asio::io_service&          io_;     ///< service providing the threads
+    boost::asio::io_service::strand   strand_; ///< serializes the messages if needed
+
+    bool                      serialized_;    ///< messages are executed one at a time
+    size_t                    pending_;       ///< messages posted and not yet executed
+    size_t                    failed_;        ///< messages whose handler threw, without a promise to tell
+
+    execution_type            exec_;          ///< function to handle each message
+
+    dispatcher_type           dispatch_;      ///< dispatcher of tasks
+
+    pipe_type                 pipe_;          ///< possible holds a pipe
+
+public: // methods
+
+    /// Constructor
+    /// @param serialized executes messages one at a time, as an Active with a single thread
+    AsioActive( boost::asio::io_service& io,
+                execution_type x,
+                bool serialized = true ) :
+        io_(io),
+        strand_(io),
+        serialized_(serialized),
+        pending_(0),
+        failed_(0),
+        exec_(x),
+        dispatch_(),
+        pipe_()
+    {
+    }
+
+    /// Destructor
+    /// Never waits: posted messages hold a reference, so none is left when it runs
+    virtual ~AsioActive()
+    {
+    }
+
+    /// Posts a message
+    virtual void send( message_type msg )
+    {
+        boost::unique_lock<boost::mutex> lock(m_);
+
+        work_type w = boost::bind( dispatch_, pipe_, exec_, msg );
+
+        ++pending_;
+
+        lock.unlock();
+
+        post( w, promise_ptr() );
+    }
+
+    /// Posts a message
+    /// @returns on promise passed from outsides
+    virtual void send( message_type msg, promise_ptr p )
+    {
+        boost::unique_lock<boost::mutex> lock(m_);
+
+        work_type w = boost::bind( dispatch_, pipe_, exec_, msg, p );
+
+        ++pending_;
+
+        lock.unlock();
+
+        post( w, p );
+    }
+
+    void pipe( const pipe_type& p )
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        pipe_ = p;
+    }
+
+    /// @returns the nb of messages posted and not yet executed
+    size_t qsize()
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        return pending_;
+    }
+
+    /// @returns the nb of messages whose handler threw and had no promise to hold the exception
+    size_t failed()
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        return failed_;
+    }
+
+    /// @returns the io_service running the messages
+    boost::asio::io_service& get_io_service() { return io_; }
+
+    /// @returns the strand serializing the messages, to wrap I/O handlers
+    ///          that touch the same state as the messages
+    boost::asio::io_service::strand& strand() { return strand_; }
+
+    /// Factory method
+    static AsioActive<M,R>::Ptr create( boost::asio::io_service& io, execution_type x, bool serialized = true )
+    {
+        return AsioActive<M,R>::Ptr( new AsioActive<M,R>(io,x,serialized) );
+    }
+
+protected: // methods
+
+    void post( const work_type& w, const promise_ptr& p )
+    {
+        if( serialized_ )
+            strand_.post( boost::bind( &AsioActive<M,R>::execute, this->shared_from_this(), w, p ) );
+        else
+            io_.post( boost::bind( &AsioActive<M,R>::execute, this->shared_from_this(), w, p ) );
+    }
+
+    void execute( const work_type& w, const promise_ptr& p )
+    {
+        bool told = false;
+        try
+        {
+            w();
+        }
+        catch(...)
+        {
+            if( p )
+            {
+                try
+                {
+                    p->set_exception( boost::current_exception() );
+                    told = true;
+                }
+                catch( boost::promise_already_satisfied& ) {} // thrown by the pipe, after the result
+            }
+            if( !told )
+            {
+                boost::lock_guard<boost::mutex> lock(m_);
+                ++failed_;
+            }
+        }
+
+        boost::lock_guard<boost::mutex> lock(m_);
+        --pending_;
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+
+/// Runs an io_service on a group of threads until destroyed
+/// Keeps the service alive while there is no work
+class AsioThreads : private boost::noncopyable {
+
+public: // methods
+
+    AsioThreads( boost::asio::io_service& io, size_t nb_threads = boost::thread::hardware_concurrency() ) :
+        io_(io),
+        work_( new boost::asio::io_service::work(io) )
+    {
+        typedef std::size_t ( boost::asio::io_service::*run_type )();
+
+        for( size_t i = 0; i < ( nb_threads ? nb_threads : 1 ); ++i )
+            threads_.create_thread( boost::bind( static_cast<run_type>( &boost::asio::io_service::run ), &io_ ) );
+    }
+
+    /// Destructor
+    /// Lets the threads finish the outstanding handlers, then joins them
+    ~AsioThreads()
+    {
+        work_.reset();
+        threads_.join_all();
+    }
+
+    /// @returns the nb of threads running the io_service
+    size_t size() const { return threads_.size(); }
+
+private: // data
+
+    boost::asio::io_service& io_;
+    boost::scoped_ptr< boost::asio::io_service::work > work_;
+    boost::thread_group      threads_;
+
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
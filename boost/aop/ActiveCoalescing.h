@@ -0,0 +1,222 @@
+#ifndef ActiveCoalescing_h
+#define ActiveCoalescing_h
+
+#define BOOST_THREAD_VERSION 3
+
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "Active.h"
+#include "coalescing_queue.h"
+
+//-----------------------------------------------------------------------------
+
+/// Active object that only keeps the latest message per key
+///
+/// A message whose key is already queued replaces the queued message in place,
+/// so under bursts the work is bounded by the nb of distinct keys, not the update rate.
+/// Callers of replaced messages get the result of the message that replaced theirs.
+/// A queued key holds at most max_waiters promises, later callers of that key
+/// get an Exception instead of growing the entry without limit.
+/// With more than one thread, messages with the same key may still run concurrently
+/// if one arrives while the previous is executing.
+
+template < typename M, typename R, typename K >
+class CoalescingActive : public IActive<M> {
+
+public: // types
+
+    typedef boost::shared_ptr< CoalescingActive<M,R,K> > Ptr;
+
+    class Exception {};
+
+    typedef M message_type;
+    typedef R result_type;
+    typedef K key_type;
+
+    typedef typename boost::promise<result_type>         promise_type;
+    typedef typename boost::shared_ptr< promise_type >   promise_ptr;
+    typedef typename boost::future<result_type>          future_type;
+
+    typedef boost::function< result_type ( message_type ) > execution_type;
+
+    typedef boost::function< key_type ( const message_type& ) > key_function_type;
+
+    typedef typename IActive<result_type>::Ptr  pipe_type;
+
+protected: // types
+
+    /// Latest message for a key and everyone waiting for it
+    struct update
+    {
+        update() {}
+        update( const message_type& m ) : msg(m) {}
+
+        message_type               msg;
+        std::vector< promise_ptr > promises;
+    };
+
+    typedef boost::shared_ptr< boost::thread > thread_ptr;
+
+    typedef typename detail::Fanout<result_type> dispatcher_type;
+
+protected: // data
+
+    mutable boost::mutex      m_;             ///< mutex for locking changes in the Active object itself
+
+    bool                      done_;          ///< flag for finishing
+
+    execution_type            exec_;          ///< function to handle each message
+
+    key_function_type         key_;           ///< extracts the key of each message
+
+    std::vector< thread_ptr > threads_;       ///< multiple threads object
+
+    const size_t              max_waiters_;   ///< max nb of promises held by a queued key
+
+    coalescing_queue<key_type,update> mq_;    ///< message queue
+
+    dispatcher_type           dispatch_;      ///< dispatcher of tasks
+
+    pipe_type                 pipe_;          ///< possible holds a pipe
+
+public: // methods
+
+    /// Constructor
+    /// Starts up everything, using run as the thread mainline
+    /// @param qsize is the max nb of distinct keys queued, 0 is unlimited
+    /// @param max_waiters is the max nb of promises waiting on a queued key
+    CoalescingActive( execution_type x,
+                      key_function_type k,
+                      size_t nb_threads = 1,
+                      size_t qsize = 0,
+                      size_t max_waiters = 64 ) :
+        done_(false),
+        exec_(x),
+        key_(k),
+        max_waiters_( max_waiters ? max_waiters : 1 ),
+        mq_( qsize, boost::bind( &CoalescingActive<M,R,K>::merge, this, _1, _2 ) ),
+        dispatch_(),
+        pipe_()
+    {
+        spawn_threads(nb_threads);
+    }
+
+    /// Destructor
+    /// Wait for queue to drain
+    virtual ~CoalescingActive()
+    {
+        mq_.drain_and_close();
+        done_ = true;
+
+        // wait for all threads still processing queue messages to exit normally
+        for( size_t i = 0; i < threads_.size(); ++i )
+            if( threads_[i]->joinable() )
+                threads_[i]->join();
+    }
+
+    /// Enqueue a message, replacing the queued one with the same key
+    virtual void send( message_type msg )
+    {
+        if( ! mq_.wait_and_push( key_(msg), update(msg) ) )
+            throw CoalescingActive<M,R,K>::Exception();
+    }
+
+    /// Enqueues a message, replacing the queued one with the same key
+    /// @returns on promise passed from outsides the result of the latest message for the key
+    virtual void send( message_type msg, promise_ptr p )
+    {
+        update u(msg);
+        u.promises.push_back(p);
+
+        if( ! mq_.wait_and_push( key_(msg), u ) )
+            throw CoalescingActive<M,R,K>::Exception();
+    }
+
+    void pipe( const pipe_type& p )
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        pipe_ = p;
+    }
+
+    /// @returns the nb worker threads
+    size_t tsize()
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        return threads_.size();
+    }
+
+    /// @returns the current nb of distinct keys queued
+    size_t qsize() { return mq_.size(); }
+
+    /// sets the maximum nb of distinct keys queued
+    void qsize( const size_t& s ) { mq_.max_size(s); }
+
+    /// @returns the nb of messages replaced before being executed
+    size_t coalesced() { return mq_.coalesced(); }
+
+    /// @returns the max nb of promises waiting on a queued key
+    size_t max_waiters() const { return max_waiters_; }
+
+    /// Factory method
+    static CoalescingActive<M,R,K>::Ptr create( execution_type x, key_function_type k, size_t nb_threads = 1, size_t qsize = 0, size_t max_waiters = 64 )
+    {
+        return CoalescingActive<M,R,K>::Ptr( new CoalescingActive<M,R,K>(x,k,nb_threads,qsize,max_waiters) );
+    }
+
+protected: // methods
+
+    /// Keeps the newest message and the promises up to max_waiters
+    /// Promises past the cap are failed with an Exception, called under the queue lock
+    void merge( update& queued, const update& incoming )
+    {
+        queued.msg = incoming.msg;
+        for( size_t i = 0; i < incoming.promises.size(); ++i )
+        {
+            if( queued.promises.size() < max_waiters_ )
+                queued.promises.push_back( incoming.promises[i] );
+            else
+                incoming.promises[i]->set_exception( boost::copy_exception( CoalescingActive<M,R,K>::Exception() ) );
+        }
+    }
+
+    void spawn_threads( size_t nb_threads )
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        for( size_t i = 0; i < nb_threads; ++i )
+            threads_.push_back( thread_ptr( new boost::thread(&CoalescingActive<M,R,K>::run, this ) ) );
+    }
+
+    virtual void run()
+    {
+        update u;
+        while (!done_)
+        {
+            try
+            {
+                if( mq_.try_and_pop(u) )
+                {
+                    boost::unique_lock<boost::mutex> lock(m_);
+                    pipe_type p = pipe_;
+                    lock.unlock();
+
+                    dispatch_( p, exec_, u.msg, u.promises );
+                }
+                else
+                    boost::this_thread::yield();
+            }
+            catch ( boost::thread_interrupted& e )
+            {
+                break; //< finish this thread
+            }
+        }
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,192 @@
+#ifndef ActiveGroup_h
+#define ActiveGroup_h
+
+#define BOOST_THREAD_VERSION 3
+
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/random/linear_congruential.hpp>
+#include <boost/thread/tss.hpp>
+
+#include "Active.h"
+
+//-----------------------------------------------------------------------------
+
+/// Front-end balancing messages over replicated Active objects
+///
+/// Each member keeps its own queue, so there is no single shared queue to contend on.
+/// Messages are routed either to the shorter queue of two random members (two choices),
+/// or to the member with least outstanding work, queued plus executing.
+/// With a key function, messages with the same key always go to the same member.
+
+template < typename M, typename R >
+class ActiveGroup : public IActive<M> {
+
+public: // types
+
+    typedef boost::shared_ptr< ActiveGroup<M,R> > Ptr;
+
+    typedef M message_type;
+    typedef R result_type;
+
+    typedef Active<M,R>                       member_type;
+    typedef typename member_type::Ptr         member_ptr;
+    typedef typename member_type::promise_ptr promise_ptr;
+    typedef typename member_type::execution_type execution_type;
+
+    /// @returns the key of a message, members are chosen as key % size()
+    typedef boost::function< size_t ( const message_type& ) > key_function_type;
+
+    enum routing
+    {
+        TWO_CHOICES,        ///< shorter queue of two random members
+        LEAST_OUTSTANDING,  ///< least queued plus executing messages among all members
+        RANDOM              ///< any member, as a baseline
+    };
+
+protected: // data
+
+    std::vector< member_ptr > members_;   ///< fixed after construction, so routing takes no lock
+
+    routing                   routing_;   ///< how to choose a member
+
+    key_function_type         key_;       ///< key affinity, if set
+
+    boost::thread_specific_ptr< boost::random::minstd_rand > gen_;  ///< per thread, so producers don't contend
+
+public: // methods
+
+    /// Constructor
+    /// @param members are the replicated Active objects, must not be empty
+    ActiveGroup( const std::vector< member_ptr >& members,
+                 routing r = TWO_CHOICES,
+                 key_function_type k = key_function_type() ) :
+        members_(members),
+        routing_(r),
+        key_(k)
+    {
+    }
+
+    /// Routes a message to a member
+    virtual void send( message_type msg )
+    {
+        members_[ pick(msg) ]->send( msg );
+    }
+
+    /// Routes a message to a member
+    /// @returns on promise passed from outsides
+    void send( message_type msg, promise_ptr p )
+    {
+        members_[ pick(msg) ]->send( msg, p );
+    }
+
+    /// Routes a message to a member, never blocks
+    /// @returns ADMITTED or the reason the member rejected the message
+    admission_status try_send( message_type msg, promise_ptr p = promise_ptr() )
+    {
+        size_t i = pick(msg);
+        return p ? members_[i]->try_send( msg, p ) : members_[i]->try_send( msg );
+    }
+
+    /// Sets the pipe of all members
+    void pipe( const typename member_type::pipe_type& p )
+    {
+        for( size_t i = 0; i < members_.size(); ++i )
+            members_[i]->pipe( p );
+    }
+
+    /// @returns the nb of members
+    size_t size() const { return members_.size(); }
+
+    /// @returns a member
+    member_ptr member( size_t i ) const { return members_[i]; }
+
+    /// @returns the sum of the members queue sizes
+    size_t qsize()
+    {
+        size_t n = 0;
+        for( size_t i = 0; i < members_.size(); ++i )
+            n += members_[i]->qsize();
+        return n;
+    }
+
+    /// @returns the index of the member a message is routed to
+    size_t pick( const message_type& msg )
+    {
+        const size_t n = members_.size();
+
+        if( key_ )
+            return key_(msg) % n;
+
+        if( n == 1 )
+            return 0;
+
+        switch( routing_ )
+        {
+            case LEAST_OUTSTANDING:
+            {
+                size_t best = 0;
+                size_t load = members_[0]->outstanding();
+                for( size_t i = 1; i < n && load; ++i )
+                {
+                    size_t l = members_[i]->outstanding();
+                    if( l < load )
+                    {
+                        best = i;
+                        load = l;
+                    }
+                }
+                return best;
+            }
+
+            case RANDOM:
+                return random() % n;
+
+            case TWO_CHOICES:
+            default:
+            {
+                size_t a = random() % n;
+                size_t b = random() % (n - 1);
+                if( b >= a ) // distinct from a
+                    ++b;
+                return members_[b]->qsize() < members_[a]->qsize() ? b : a;
+            }
+        }
+    }
+
+    /// Factory method
+    /// Creates the group with its members, all executing the same function
+    static ActiveGroup<M,R>::Ptr create( execution_type x,
+                                         size_t nb_members,
+                                         size_t nb_threads = 1,
+                                         size_t qsize = 0,
+                                         routing r = TWO_CHOICES,
+                                         key_function_type k = key_function_type() )
+    {
+        std::vector< member_ptr > members;
+        for( size_t i = 0; i < nb_members; ++i )
+            members.push_back( member_type::create( x, nb_threads, qsize ) );
+        return ActiveGroup<M,R>::Ptr( new ActiveGroup<M,R>(members,r,k) );
+    }
+
+protected: // methods
+
+    size_t random()
+    {
+        boost::random::minstd_rand* g = gen_.get();
+        if( !g )
+        {
+            g = new boost::random::minstd_rand( boost::hash<boost::thread::id>()( boost::this_thread::get_id() ) );
+            gen_.reset(g);
+        }
+        return (*g)();
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,341 @@
+#ifndef ActiveLanes_h
+#define ActiveLanes_h
+
+#define BOOST_THREAD_VERSION 3
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "Active.h"
+
+//-----------------------------------------------------------------------------
+
+/// Active object with several named lanes, each with its own queue
+///
+/// Worker threads serve the lanes either by strict priority, in the order the lanes
+/// were added, or weighted fair, each non empty lane getting a share of the messages
+/// proportional to its weight. A lane can also have reserved workers serving only it,
+/// so its latency does not depend on how busy the shared workers are.
+
+template < typename M, typename R >
+class LanedActive : public IActive<M> {
+
+public: // types
+
+    typedef boost::shared_ptr< LanedActive<M,R> > Ptr;
+
+    class Exception {};
+
+    typedef M message_type;
+    typedef R result_type;
+
+    typedef typename boost::promise<result_type>         promise_type;
+    typedef typename boost::shared_ptr< promise_type >   promise_ptr;
+    typedef typename boost::future<result_type>          future_type;
+
+    typedef boost::function< result_type ( message_type ) > execution_type;
+
+    typedef typename IActive<result_type>::Ptr  pipe_type;
+
+    enum service
+    {
+        STRICT_PRIORITY,   ///< always the first non empty lane
+        WEIGHTED_FAIR      ///< non empty lanes in proportion to their weights
+    };
+
+protected: // types
+
+    typedef boost::function< void () > work_type;
+
+    struct lane
+    {
+        lane( const std::string& n, size_t q, size_t w ) :
+            name(n), weight(w ? w : 1), credit(0), processed(0), mq(q) {}
+
+        std::string              name;
+        size_t                   weight;
+        long                     credit;      ///< for the smooth weighted round robin
+        boost::atomic<size_t>    processed;   ///< counted without the lock
+        message_queue<work_type> mq;
+    };
+
+    typedef boost::shared_ptr< lane > lane_ptr;
+
+    typedef typename detail::Dispatcher<result_type> dispatcher_type;
+
+protected: // data
+
+    mutable boost::mutex      m_;             ///< mutex for the lanes and the service state
+
+    bool                      done_;          ///< flag for finishing
+
+    execution_type            exec_;          ///< function to handle each message
+
+    service                   service_;       ///< how shared workers choose a lane
+
+    std::vector< lane_ptr >   lanes_;         ///< in priority order
+    std::map< std::string, size_t > names_;   ///< lane index by name
+
+    boost::thread_group       threads_;       ///< shared and reserved workers
+
+    dispatcher_type           dispatch_;      ///< dispatcher of tasks
+
+    pipe_type                 pipe_;          ///< possible holds a pipe
+
+public: // methods
+
+    /// Constructor
+    /// Starts the shared workers, there is no lane until add_lane
+    LanedActive( execution_type x,
+                 size_t nb_threads = 1,
+                 service s = WEIGHTED_FAIR ) :
+        done_(false),
+        exec_(x),
+        service_(s),
+        dispatch_(),
+        pipe_()
+    {
+        for( size_t i = 0; i < nb_threads; ++i )
+            threads_.create_thread( boost::bind( &LanedActive<M,R>::run, this ) );
+    }
+
+    /// Destructor
+    /// Wait for all lanes to drain
+    virtual ~LanedActive()
+    {
+        std::vector< lane_ptr > lanes;
+        {
+            boost::lock_guard<boost::mutex> lock(m_);
+            lanes = lanes_;
+        }
+
+        for( size_t i = 0; i < lanes.size(); ++i )
+            lanes[i]->mq.drain_and_close();
+        done_ = true;
+
+        threads_.join_all();
+    }
+
+    /// Adds a lane, with lower priority than the existing ones
+    /// @param qsize is the max nb of messages queued in the lane, 0 is unlimited
+    /// @param weight is the relative share of the lane under weighted fair service
+    /// @returns the lane index, to send to
+    size_t add_lane( const std::string& name, size_t qsize = 0, size_t weight = 1 )
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+
+        if( names_.count(name) )
+            throw LanedActive<M,R>::Exception();
+
+        lanes_.push_back( lane_ptr( new lane( name, qsize, weight ) ) );
+        names_[name] = lanes_.size() - 1;
+        return lanes_.size() - 1;
+    }
+
+    /// Adds a worker that only serves this lane
+    void reserve( size_t l )
+    {
+        threads_.create_thread( boost::bind( &LanedActive<M,R>::serve, this, get(l) ) );
+    }
+
+    /// @returns the index of a lane, throws Exception if there is none by that name
+    size_t lane_index( const std::string& name ) const
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        typename std::map< std::string, size_t >::const_iterator itr = names_.find(name);
+        if( itr == names_.end() )
+            throw LanedActive<M,R>::Exception();
+        return itr->second;
+    }
+
+    /// Enqueue a message in the first lane
+    virtual void send( message_type msg ) { send( 0, msg ); }
+
+    /// Enqueue a message in a lane, blocks while the lane is full
+    void send( size_t l, message_type msg )
+    {
+        pipe_type p;
+        lane_ptr  ln = get( l, p );
+        if( ! ln->mq.wait_and_push( boost::bind( dispatch_, p, exec_, msg ) ) )
+            throw LanedActive<M,R>::Exception();
+    }
+
+    /// Enqueues a message in a lane, blocks while the lane is full
+    /// @returns on promise passed from outsides
+    void send( size_t l, message_type msg, promise_ptr pr )
+    {
+        pipe_type p;
+        lane_ptr  ln = get( l, p );
+        if( ! ln->mq.wait_and_push( boost::bind( dispatch_, p, exec_, msg, pr ) ) )
+            throw LanedActive<M,R>::Exception();
+    }
+
+    /// Enqueues a message in a lane if it is not full, never blocks
+    /// @returns ADMITTED or the reason the message was rejected
+    admission_status try_send( size_t l, message_type msg )
+    {
+        pipe_type p;
+        lane_ptr  ln = get( l, p );
+        return ln->mq.try_push( boost::bind( dispatch_, p, exec_, msg ) );
+    }
+
+    void pipe( const pipe_type& p )
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        pipe_ = p;
+    }
+
+    /// @returns the nb of lanes
+    size_t lanes() const
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        return lanes_.size();
+    }
+
+    /// @returns the current queue size of a lane
+    size_t qsize( size_t l ) { return get(l)->mq.size(); }
+
+    /// @returns the nb of messages executed from a lane
+    size_t processed( size_t l )
+    {
+        return get(l)->processed.load( boost::memory_order_relaxed );
+    }
+
+    /// @returns the nb worker threads, shared and reserved
+    size_t tsize() { return threads_.size(); }
+
+    /// Factory method
+    static LanedActive<M,R>::Ptr create( execution_type x, size_t nb_threads = 1, service s = WEIGHTED_FAIR )
+    {
+        return LanedActive<M,R>::Ptr( new LanedActive<M,R>(x,nb_threads,s) );
+    }
+
+protected: // methods
+
+    lane_ptr get( size_t l ) const
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        if( l >= lanes_.size() )
+            throw LanedActive<M,R>::Exception();
+        return lanes_[l];
+    }
+
+    /// @returns the lane, and the pipe in p, under a single lock
+    lane_ptr get( size_t l, pipe_type& p ) const
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        if( l >= lanes_.size() )
+            throw LanedActive<M,R>::Exception();
+        p = pipe_;
+        return lanes_[l];
+    }
+
+    /// Chooses the lane to serve next and takes its oldest message
+    /// The lane is chosen under the lock and popped outside it, so a worker racing
+    /// for the same message only makes this one come back empty handed
+    /// @returns the lane, or an empty pointer if no message was taken
+    lane_ptr next( work_type& w )
+    {
+        lane_ptr l = choose();
+        return l && l->mq.try_and_pop(w) ? l : lane_ptr();
+    }
+
+    /// @returns the lane to serve next, or an empty pointer if all lanes are empty
+    lane_ptr choose()
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+
+        if( service_ == STRICT_PRIORITY )
+        {
+            for( size_t i = 0; i < lanes_.size(); ++i )
+                if( !lanes_[i]->mq.empty() )
+                    return lanes_[i];
+            return lane_ptr();
+        }
+
+        // smooth weighted round robin: every non empty lane earns its weight in credit,
+        // the richest is served and pays back the total, so shares follow the weights
+        // without long runs of the same lane. An empty lane loses its credit, so it
+        // does not come back with a burst, or a debt, earned before it went idle
+
+        long total = 0;
+        lane_ptr best;
+        for( size_t i = 0; i < lanes_.size(); ++i )
+        {
+            lane_ptr l = lanes_[i];
+            if( l->mq.empty() )
+            {
+                l->credit = 0;
+                continue;
+            }
+            l->credit += l->weight;
+            total     += l->weight;
+            if( !best || l->credit > best->credit )
+                best = l;
+        }
+
+        if( !best )
+            return lane_ptr();
+
+        best->credit -= total;
+        return best;
+    }
+
+    /// Shared worker mainline, serving all lanes
+    void run()
+    {
+        work_type w;
+        while (!done_)
+        {
+            try
+            {
+                lane_ptr l = next(w);
+                if( l )
+                {
+                    w();
+                    l->processed.fetch_add( 1, boost::memory_order_relaxed );
+                }
+                else
+                    boost::this_thread::yield();
+            }
+            catch ( boost::thread_interrupted& e )
+            {
+                break; //< finish this thread
+            }
+        }
+    }
+
+    /// Reserved worker mainline, popping its lane directly without the lock
+    void serve( lane_ptr l )
+    {
+        work_type w;
+        while (!done_)
+        {
+            try
+            {
+                if( l->mq.try_and_pop(w) )
+                {
+                    w();
+                    l->processed.fetch_add( 1, boost::memory_order_relaxed );
+                }
+                else
+                    boost::this_thread::yield();
+            }
+            catch ( boost::thread_interrupted& e )
+            {
+                break; //< finish this thread
+            }
+        }
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,346 @@
+#ifndef Actor_h
+#define Actor_h
+
+#define BOOST_THREAD_VERSION 3
+
+#include <map>
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/enable_shared_from_this.hpp>
+
+#include <boost/thread/thread.hpp>
+
+#include "Active.h"
+#include "message_queue.h"
+
+//-----------------------------------------------------------------------------
+
+/// Anything that can be scheduled onto a Scheduler worker thread
+class IActor : private boost::noncopyable {
+
+public: // types
+
+    typedef boost::shared_ptr< IActor > Ptr;
+
+public: // interface
+
+    virtual ~IActor() {}
+
+    /// Processes a batch of the queued messages
+    virtual void activate() = 0;
+
+};
+
+//-----------------------------------------------------------------------------
+
+/// Small pool of worker threads shared by many actors
+///
+/// Only actors with pending messages are queued here, so idle actors
+/// cost nothing but their mailbox.
+/// Actors hold the scheduler, so the last reference may go with an actor released by
+/// a worker: the destructor then runs on that worker, which it detaches and lets exit.
+
+class Scheduler : private boost::noncopyable {
+
+public: // types
+
+    typedef boost::shared_ptr< Scheduler > Ptr;
+
+    typedef boost::shared_ptr< boost::thread > thread_ptr;
+
+protected: // data
+
+    mutable boost::mutex      m_;             ///< mutex for the pending counter
+    boost::condition_variable idle_cond_;     ///< signaled when no actor is pending
+
+    size_t                    batch_;         ///< max messages processed per activation
+    size_t                    pending_;       ///< actors queued or being activated
+
+    std::vector< thread_ptr > threads_;       ///< worker threads
+
+    std::map< boost::thread::id, bool* > gone_; ///< per worker, set if the scheduler was destroyed by it
+
+    message_queue< IActor::Ptr > ready_;      ///< actors ready to be activated
+
+public: // methods
+
+    /// Constructor
+    /// Starts up the worker threads, using run as the thread mainline
+    Scheduler( size_t nb_threads = boost::thread::hardware_concurrency(), size_t batch = 64 ) :
+        batch_( batch ? batch : 1 ),
+        pending_(0)
+    {
+        if( ! nb_threads )
+            nb_threads = 1;
+        for( size_t i = 0; i < nb_threads; ++i )
+            threads_.push_back( thread_ptr( new boost::thread(&Scheduler::run, this) ) );
+    }
+
+    /// Destructor
+    /// Waits for all pending actors to drain, then stops the workers
+    ~Scheduler()
+    {
+        drain();
+
+        // destroyed by a worker releasing the last actor: it cannot join itself
+
+        const boost::thread::id self = boost::this_thread::get_id();
+        {
+            boost::lock_guard<boost::mutex> lock(m_);
+            std::map< boost::thread::id, bool* >::iterator itr = gone_.find(self);
+            if( itr != gone_.end() )
+                *itr->second = true;
+        }
+
+        // one empty actor per worker works as the finish message
+        for( size_t i = 0; i < threads_.size(); ++i )
+            ready_.push( IActor::Ptr() );
+
+        for( size_t i = 0; i < threads_.size(); ++i )
+            if( threads_[i]->get_id() == self )
+                threads_[i]->detach();
+            else if( threads_[i]->joinable() )
+                threads_[i]->join();
+    }
+
+    /// Queues an actor for activation
+    void schedule( const IActor::Ptr& a )
+    {
+        {
+            boost::lock_guard<boost::mutex> lock(m_);
+            ++pending_;
+        }
+        ready_.push(a);
+    }
+
+    /// Blocks until no actor has pending messages
+    void drain()
+    {
+        boost::unique_lock<boost::mutex> lock(m_);
+        while( pending_ )
+            idle_cond_.wait(lock);
+    }
+
+    /// @returns the max nb of messages an actor processes per activation
+    size_t batch() const { return batch_; }
+
+    /// @returns the nb worker threads
+    size_t tsize() const { return threads_.size(); }
+
+    /// @returns the nb of actors waiting for a worker
+    size_t qsize() const { return ready_.size(); }
+
+    /// Factory method
+    static Scheduler::Ptr create( size_t nb_threads = boost::thread::hardware_concurrency(), size_t batch = 64 )
+    {
+        return Scheduler::Ptr( new Scheduler(nb_threads,batch) );
+    }
+
+protected: // methods
+
+    void run()
+    {
+        bool gone = false; // set by the destructor if it runs on this thread
+        {
+            boost::lock_guard<boost::mutex> lock(m_);
+            gone_[ boost::this_thread::get_id() ] = &gone;
+        }
+
+        IActor::Ptr a;
+        while( true )
+        {
+            ready_.wait_and_pop(a);
+
+            if( !a )
+                break; //< finish this thread
+
+            a->activate();
+
+            {
+                boost::lock_guard<boost::mutex> lock(m_);
+                if( --pending_ == 0 )
+                    idle_cond_.notify_all();
+            }
+
+            a.reset(); // may release the last reference to this scheduler
+
+            if( gone )
+                return; //< this is destroyed, touch nothing
+        }
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+
+/// Actor holding a mailbox and the state bound in its execution function
+///
+/// Messages to one actor are executed in order and never concurrently,
+/// like in an Active object with a single thread, but the actor owns no thread.
+/// Handler exceptions are counted in failed(), so that the actor stays schedulable.
+
+template < typename M >
+class Actor : public IActive<M>,
+              public IActor,
+              public boost::enable_shared_from_this< Actor<M> > {
+
+public: // types
+
+    typedef boost::shared_ptr< Actor<M> > Ptr;
+
+    typedef M message_type;
+
+    typedef boost::function< void ( message_type ) > execution_type;
+
+protected: // types
+
+    struct node
+    {
+        node( const message_type& m ) : msg(m), next(0) {}
+
+        message_type msg;
+        node*        next;
+    };
+
+protected: // data
+
+    mutable boost::mutex      m_;             ///< mutex for the mailbox
+
+    node*                     head_;          ///< oldest message in mailbox
+    node*                     tail_;          ///< newest message in mailbox
+    size_t                    size_;          ///< nb messages in mailbox
+
+    bool                      scheduled_;     ///< actor is queued or running in the scheduler
+    size_t                    failed_;        ///< nb messages whose handler threw
+
+    execution_type            exec_;          ///< function to handle each message
+
+    Scheduler::Ptr            sched_;         ///< scheduler providing the threads
+
+protected: // methods
+
+    /// Constructor
+    Actor( Scheduler::Ptr s, execution_type x ) :
+        head_(0),
+        tail_(0),
+        size_(0),
+        scheduled_(false),
+        failed_(0),
+        exec_(x),
+        sched_(s)
+    {
+    }
+
+public: // methods
+
+    /// Destructor
+    /// Discards the messages still in the mailbox
+    virtual ~Actor()
+    {
+        while( head_ )
+        {
+            node* n = head_;
+            head_ = n->next;
+            delete n;
+        }
+    }
+
+    /// Enqueue a message, scheduling the actor if it was idle
+    virtual void send( message_type msg )
+    {
+        node* n = new node(msg);
+        bool wakeup = false;
+
+        {
+            boost::lock_guard<boost::mutex> lock(m_);
+
+            if( tail_ )
+                tail_->next = n;
+            else
+                head_ = n;
+            tail_ = n;
+            ++size_;
+
+            if( !scheduled_ )
+                scheduled_ = wakeup = true;
+        }
+
+        if( wakeup )
+            sched_->schedule( this->shared_from_this() );
+    }
+
+    /// @returns the current mailbox size
+    size_t qsize() const
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        return size_;
+    }
+
+    /// @returns the nb of messages whose handler threw
+    size_t failed() const
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        return failed_;
+    }
+
+    /// Factory method
+    static Actor<M>::Ptr create( Scheduler::Ptr s, execution_type x )
+    {
+        return Actor<M>::Ptr( new Actor<M>(s,x) );
+    }
+
+protected: // methods
+
+    /// Processes up to Scheduler::batch() messages, then yields the worker
+    virtual void activate()
+    {
+        for( size_t i = 0; i < sched_->batch(); ++i )
+        {
+            boost::unique_lock<boost::mutex> lock(m_);
+
+            node* n = head_;
+            if( !n )
+            {
+                scheduled_ = false;
+                return;
+            }
+            head_ = n->next;
+            if( !head_ )
+                tail_ = 0;
+            --size_;
+
+            lock.unlock();
+
+            try
+            {
+                exec_( n->msg );
+            }
+            catch(...)
+            {
+                boost::lock_guard<boost::mutex> lock(m_);
+                ++failed_;
+            }
+
+            delete n;
+        }
+
+        // batch is exhausted, go to the back of the ready queue if there is more work
+
+        boost::unique_lock<boost::mutex> lock(m_);
+        if( head_ )
+        {
+            lock.unlock();
+            sched_->schedule( this->shared_from_this() );
+        }
+        else
+            scheduled_ = false;
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
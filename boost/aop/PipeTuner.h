@@ -0,0 +1,283 @@
+#ifndef PipeTuner_h
+#define PipeTuner_h
+
+#define BOOST_THREAD_VERSION 3
+
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <boost/chrono.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "Active.h"
+
+//-----------------------------------------------------------------------------
+
+/// Stage of a pipe as seen by the PipeTuner
+class IStage : private boost::noncopyable {
+
+public: // types
+
+    typedef boost::shared_ptr< IStage > Ptr;
+
+public: // interface
+
+    virtual ~IStage() {}
+
+    virtual size_t      qsize() = 0;
+    virtual size_t      tsize() = 0;
+    virtual bool        saturated() = 0;   ///< queue at capacity or senders blocked on it
+    virtual ActiveStats stats() = 0;
+
+    virtual void add_thread() = 0;
+    virtual bool remove_thread() = 0;
+
+};
+
+/// Adapts an Active object to the IStage interface
+template < typename AO >
+class Stage : public IStage {
+
+public: // methods
+
+    Stage( const boost::shared_ptr<AO>& ao ) : ao_(ao) {}
+
+    virtual size_t      qsize() { return ao_->qsize(); }
+    virtual size_t      tsize() { return ao_->tsize(); }
+    virtual bool        saturated()
+    {
+        size_t max = ao_->max_qsize();
+        return ( max && ao_->qsize() >= max ) || ao_->blocked();
+    }
+    virtual ActiveStats stats() { return ao_->stats(); }
+
+    virtual void add_thread()    { ao_->add_thread(); }
+    virtual bool remove_thread() { return ao_->remove_thread(); }
+
+private: // members
+
+    boost::shared_ptr<AO> ao_;
+
+};
+
+//-----------------------------------------------------------------------------
+
+/// Moves worker threads between the stages of a pipe towards its bottleneck
+///
+/// Every period the tuner samples each stage's queue and the time its threads spent busy.
+/// A stage is under pressure if its queue grew, or if it is saturated: a bounded queue held
+/// at capacity does not grow, but blocks its senders. Blocking pushes the pressure upstream,
+/// so the bottleneck is the stage under pressure furthest down the pipe (stages are added
+/// in pipe order), or the longest queue if there is no pressure.
+/// While the thread budget is not used up it gets a new thread, otherwise it takes one
+/// from the stage with the lowest utilization, provided that stage has an empty queue.
+/// One thread moves per period, so allocation converges without oscillating.
+
+class PipeTuner : private boost::noncopyable {
+
+public: // types
+
+    typedef boost::chrono::steady_clock  clock_type;
+    typedef clock_type::duration         duration;
+
+protected: // types
+
+    struct Sample
+    {
+        Sample() : stage(), qsize(0), tsize(0), utilization(0), throughput(0) {}
+
+        std::string  name;
+        IStage::Ptr  stage;
+        ActiveStats  last;          ///< counters at the previous sample
+
+        size_t       qsize;         ///< queue size at the previous sample
+        size_t       tsize;         ///< nb threads at the previous sample
+        double       utilization;   ///< fraction of the threads' time spent busy
+        double       throughput;    ///< messages per second
+    };
+
+protected: // data
+
+    mutable boost::mutex      m_;             ///< mutex for the stages
+
+    size_t                    budget_;        ///< max nb threads over all stages
+    duration                  period_;        ///< time between samples
+    clock_type::time_point    last_;          ///< time of the previous sample
+
+    std::vector< Sample >     stages_;        ///< stages of the pipe
+
+    boost::thread             thd_;           ///< tuning thread, if started
+
+public: // methods
+
+    /// Constructor
+    /// @param budget is the max nb of threads to distribute over all stages
+    PipeTuner( size_t budget, duration period = boost::chrono::milliseconds(100) ) :
+        budget_(budget),
+        period_(period),
+        last_( clock_type::now() )
+    {
+    }
+
+    /// Destructor
+    /// Stops tuning, the stages keep their current threads
+    ~PipeTuner()
+    {
+        stop();
+    }
+
+    /// Adds a stage to be tuned
+    template < typename AO >
+    void add( const boost::shared_ptr<AO>& ao, const std::string& name )
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+
+        Sample s;
+        s.name  = name;
+        s.stage = IStage::Ptr( new Stage<AO>(ao) );
+        s.last  = s.stage->stats();
+        s.qsize = s.stage->qsize();
+        s.tsize = s.stage->tsize();
+
+        stages_.push_back(s);
+    }
+
+    /// Starts tuning periodically in a background thread
+    void start()
+    {
+        thd_ = boost::thread( &PipeTuner::run, this );
+    }
+
+    /// Stops the background tuning
+    void stop()
+    {
+        if( thd_.joinable() )
+        {
+            thd_.interrupt();
+            thd_.join();
+        }
+    }
+
+    /// Samples the stages and moves at most one thread
+    void tune()
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+
+        clock_type::time_point now = clock_type::now();
+        double elapsed = boost::chrono::duration<double>( now - last_ ).count();
+        last_ = now;
+
+        if( stages_.empty() || elapsed <= 0 )
+            return;
+
+        size_t total = 0;
+
+        size_t max_qsize  = 0;
+        size_t longest    = stages_.size();
+        size_t bottleneck = stages_.size();
+
+        double min_util = 2;
+        size_t donor    = stages_.size();
+
+        for( size_t i = 0; i < stages_.size(); ++i )
+        {
+            Sample& s = stages_[i];
+
+            ActiveStats st = s.stage->stats();
+            size_t q = s.stage->qsize();
+            bool full = s.stage->saturated();
+
+            double busy = boost::chrono::duration<double>( st.busy - s.last.busy ).count();
+
+            s.throughput  = ( st.processed - s.last.processed ) / elapsed;
+            s.utilization = busy / ( elapsed * std::max<size_t>( s.tsize, 1 ) );
+
+            long growth = long(q) - long(s.qsize);
+
+            s.last  = st;
+            s.qsize = q;
+            s.tsize = s.stage->tsize();
+
+            total += s.tsize;
+
+            if( growth > 0 || full )
+                bottleneck = i;
+
+            if( q > max_qsize )
+            {
+                max_qsize = q;
+                longest   = i;
+            }
+
+            if( q == 0 && !full && s.tsize > 1 && s.utilization < min_util )
+            {
+                min_util = s.utilization;
+                donor    = i;
+            }
+        }
+
+        if( bottleneck == stages_.size() )
+            bottleneck = longest;
+
+        if( bottleneck == stages_.size() ) // nothing is queuing up
+            return;
+
+        if( total < budget_ )
+        {
+            stages_[bottleneck].stage->add_thread();
+            ++stages_[bottleneck].tsize;
+            return;
+        }
+
+        if( donor != stages_.size() && donor != bottleneck && stages_[donor].stage->remove_thread() )
+        {
+            --stages_[donor].tsize;
+            stages_[bottleneck].stage->add_thread();
+            ++stages_[bottleneck].tsize;
+        }
+    }
+
+    /// Prints the last sample of each stage
+    void print( std::ostream& out ) const
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+
+        for( size_t i = 0; i < stages_.size(); ++i )
+        {
+            const Sample& s = stages_[i];
+            out << "[" << s.name
+                << " t " << std::setw(2) << s.tsize
+                << " q " << std::setw(5) << s.qsize
+                << " u " << std::setw(3) << int( 100 * s.utilization ) << "%"
+                << " " << std::setw(6) << long( s.throughput ) << "/s] ";
+        }
+        out << "\n" << std::flush;
+    }
+
+protected: // methods
+
+    void run()
+    {
+        while( true )
+        {
+            try
+            {
+                boost::this_thread::sleep_for( period_ );
+                tune();
+            }
+            catch ( boost::thread_interrupted& e )
+            {
+                break;
+            }
+        }
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
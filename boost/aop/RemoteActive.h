@@ -0,0 +1,551 @@
+#ifndef RemoteActive_h
+#define RemoteActive_h
+
+#define BOOST_THREAD_VERSION 3
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/bind.hpp>
+#include <boost/chrono.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include "Active.h"
+#include "Serialize.h"
+
+//-----------------------------------------------------------------------------
+
+/// How a message type goes on the wire, specialize for other encodings
+/// By default in binary, see binary_traits in Serialize.h
+template < typename M >
+struct wire_traits
+{
+    /// Appends the encoded message
+    static void encode( const M& m, std::string& out )
+    {
+        binary_encode( m, out );
+    }
+
+    /// @returns the message decoded from n bytes, throws if they are not a valid encoding
+    static M decode( const char* p, size_t n )
+    {
+        return binary_decode<M>( p, n );
+    }
+};
+
+/// Text encoding through boost::lexical_cast, for types that only have stream operators:
+///   template <> struct wire_traits<Foo> : text_wire_traits<Foo> {};
+template < typename M >
+struct text_wire_traits
+{
+    static void encode( const M& m, std::string& out )
+    {
+        out += boost::lexical_cast<std::string>( m );
+    }
+
+    static M decode( const char* p, size_t n )
+    {
+        return boost::lexical_cast<M>( std::string( p, n ) );
+    }
+};
+
+namespace detail {
+
+/// Frames are a 4 byte little endian length followed by the encoded message
+const size_t frame_header = 4;
+
+inline void put_length( char* p, boost::uint32_t n )
+{
+    for( size_t i = 0; i < frame_header; ++i )
+        p[i] = char( ( n >> ( 8 * i ) ) & 0xff );
+}
+
+inline boost::uint32_t get_length( const char* p )
+{
+    boost::uint32_t n = 0;
+    for( size_t i = 0; i < frame_header; ++i )
+        n |= boost::uint32_t( (unsigned char) p[i] ) << ( 8 * i );
+    return n;
+}
+
+}
+
+//-----------------------------------------------------------------------------
+
+/// Proxy to an Active object in another process or host
+///
+/// Messages are encoded as they are sent and written asynchronously, never waiting for
+/// an answer, so the sender overlaps with the network (pipelining). While one write is
+/// in progress, further messages accumulate and then leave together in a single
+/// scatter/gather write of all their frames (batching).
+/// Works over any asio stream protocol, e.g. local::stream_protocol or ip::tcp.
+
+template < typename M, typename Protocol = boost::asio::local::stream_protocol >
+class RemoteActive : public IActive<M> {
+
+public: // types
+
+    typedef boost::shared_ptr< RemoteActive<M,Protocol> > Ptr;
+
+    class Exception {};
+
+    typedef M message_type;
+
+    typedef typename Protocol::socket    socket_type;
+    typedef typename Protocol::endpoint  endpoint_type;
+
+protected: // types
+
+    /// Socket and write state, held by the write handlers too, so they never outlive it
+    class connection : public boost::enable_shared_from_this<connection> {
+
+    public: // methods
+
+        connection( boost::asio::io_service& io, size_t max_pending ) :
+            socket(io),
+            max_pending(max_pending),
+            failed(false),
+            closing(false),
+            sent(0),
+            writes(0)
+        {
+        }
+
+        /// Writes all pending frames in one go, must be called locked and with no write in progress
+        void write()
+        {
+            writing.swap( pending );
+
+            std::vector< boost::asio::const_buffer > buffers;
+            buffers.reserve( writing.size() );
+            for( size_t i = 0; i < writing.size(); ++i )
+                buffers.push_back( boost::asio::buffer( writing[i] ) );
+
+            ++writes;
+
+            boost::asio::async_write( socket, buffers,
+                                      boost::bind( &connection::written, this->shared_from_this(),
+                                                   boost::asio::placeholders::error ) );
+
+            cond.notify_all(); // room for senders
+        }
+
+        /// Closes the socket, must be called locked and with no write in progress
+        void close()
+        {
+            boost::system::error_code ec;
+            socket.shutdown( socket_type::shutdown_send, ec );
+            socket.close( ec );
+        }
+
+        void written( const boost::system::error_code& ec )
+        {
+            boost::lock_guard<boost::mutex> lock(m);
+
+            if( ec )
+            {
+                failed = true;
+                pending.clear();
+                writing.clear();
+                cond.notify_all();
+                return;
+            }
+
+            sent += writing.size();
+            writing.clear();
+
+            if( closing ) // the proxy is gone, only this write was left
+                close();
+            else if( !pending.empty() )
+                write();
+            else
+                cond.notify_all();
+        }
+
+    public: // data
+
+        mutable boost::mutex      m;              ///< mutex for the frames and write state
+        boost::condition_variable cond;           ///< signaled when frames are written
+
+        socket_type               socket;         ///< connection to the server
+
+        std::vector<std::string>  pending;        ///< frames waiting for the next write
+        std::vector<std::string>  writing;        ///< frames of the write in progress
+
+        size_t                    max_pending;    ///< max frames waiting, 0 is unlimited
+        bool                      failed;         ///< the connection broke
+        bool                      closing;        ///< close once the write in progress completes
+        size_t                    sent;           ///< nb messages written
+        size_t                    writes;         ///< nb writes, each carrying a batch
+    };
+
+    typedef boost::shared_ptr<connection> connection_ptr;
+
+protected: // data
+
+    connection_ptr                   c_;       ///< shared with the write in progress, if any
+    boost::chrono::milliseconds      linger_;  ///< max time the destructor waits for the pending messages
+
+public: // methods
+
+    /// Constructor
+    /// Connects to the server, throws boost::system::system_error on failure
+    /// @param max_pending is the nb of messages waiting to be written before send blocks, 0 is unlimited
+    RemoteActive( boost::asio::io_service& io,
+                  const endpoint_type& ep,
+                  size_t max_pending = 0 ) :
+        c_( new connection( io, max_pending ) ),
+        linger_( boost::chrono::seconds(5) )
+    {
+        c_->socket.connect(ep);
+    }
+
+    /// Destructor
+    /// Waits up to the linger time for the pending messages to be written, e.g. if the
+    /// io_service is not running, then discards them. A write still in progress closes
+    /// the socket when it completes.
+    virtual ~RemoteActive()
+    {
+        flush( linger_ );
+
+        boost::lock_guard<boost::mutex> lock( c_->m );
+        c_->pending.clear();
+        if( c_->writing.empty() )
+            c_->close();
+        else
+            c_->closing = true;
+    }
+
+    /// Encodes and queues a message for writing, blocks while max_pending messages are waiting
+    virtual void send( message_type msg )
+    {
+        std::string frame( detail::frame_header, '\0' );
+        wire_traits<M>::encode( msg, frame );
+        detail::put_length( &frame[0], boost::uint32_t( frame.size() - detail::frame_header ) );
+
+        connection& c = *c_;
+        boost::unique_lock<boost::mutex> lock( c.m );
+
+        while( c.max_pending && c.pending.size() >= c.max_pending && !c.failed )
+            c.cond.wait(lock);
+
+        if( c.failed )
+            throw RemoteActive<M,Protocol>::Exception();
+
+        c.pending.push_back( std::string() );
+        c.pending.back().swap( frame );
+
+        if( c.writing.empty() )
+            c.write();
+    }
+
+    /// Waits until all queued messages are written
+    /// @returns false if the connection broke
+    bool flush()
+    {
+        connection& c = *c_;
+        boost::unique_lock<boost::mutex> lock( c.m );
+        while( !( c.pending.empty() && c.writing.empty() ) && !c.failed )
+            c.cond.wait(lock);
+        return !c.failed;
+    }
+
+    /// Waits at most t until all queued messages are written
+    /// @returns false if the connection broke or messages are still queued
+    bool flush( boost::chrono::milliseconds t )
+    {
+        boost::chrono::steady_clock::time_point deadline = boost::chrono::steady_clock::now() + t;
+
+        connection& c = *c_;
+        boost::unique_lock<boost::mutex> lock( c.m );
+        while( !( c.pending.empty() && c.writing.empty() ) && !c.failed )
+            if( c.cond.wait_until( lock, deadline ) == boost::cv_status::timeout )
+                break;
+        return !c.failed && c.pending.empty() && c.writing.empty();
+    }
+
+    /// Sets the max time the destructor waits for the pending messages to be written
+    void linger( boost::chrono::milliseconds t ) { linger_ = t; }
+
+    /// @returns the nb of messages written
+    size_t sent() const
+    {
+        boost::lock_guard<boost::mutex> lock( c_->m );
+        return c_->sent;
+    }
+
+    /// @returns the nb of writes, sent() / writes() is the average batch
+    size_t writes() const
+    {
+        boost::lock_guard<boost::mutex> lock( c_->m );
+        return c_->writes;
+    }
+
+    /// @returns the nb of messages waiting to be written
+    size_t qsize() const
+    {
+        boost::lock_guard<boost::mutex> lock( c_->m );
+        return c_->pending.size() + c_->writing.size();
+    }
+
+    /// @returns the socket, e.g. to set options like ip::tcp::no_delay
+    socket_type& socket() { return c_->socket; }
+
+    /// Factory method
+    static RemoteActive<M,Protocol>::Ptr create( boost::asio::io_service& io, const endpoint_type& ep, size_t max_pending = 0 )
+    {
+        return RemoteActive<M,Protocol>::Ptr( new RemoteActive<M,Protocol>(io,ep,max_pending) );
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+
+/// Server side of RemoteActive, feeds the decoded messages to a local IActive
+///
+/// Each connection reads whatever is available and sends every complete frame on.
+/// The local sink may block (e.g. a bounded Active), which stops reading the
+/// connection and so pushes back on the remote sender through the socket.
+/// Frames above the max frame size are taken as a corrupt stream and drop the connection.
+
+template < typename M, typename Protocol = boost::asio::local::stream_protocol >
+class RemoteServer : private boost::noncopyable {
+
+public: // types
+
+    typedef boost::shared_ptr< RemoteServer<M,Protocol> > Ptr;
+
+    class Exception {};
+
+    typedef M message_type;
+
+    typedef typename Protocol::socket    socket_type;
+    typedef typename Protocol::endpoint  endpoint_type;
+    typedef typename Protocol::acceptor  acceptor_type;
+
+    typedef typename IActive<M>::Ptr     sink_type;
+
+protected: // types
+
+    class session;
+
+    typedef boost::shared_ptr<session> session_ptr;
+
+    /// State shared by the server and its sessions, which may outlive it
+    struct registry
+    {
+        registry() : closed(false), received(0) {}
+
+        boost::mutex                            m;
+        bool                                    closed;    ///< the server is gone
+        size_t                                  received;  ///< nb messages received
+        std::vector< boost::weak_ptr<session> > sessions;  ///< to close them with the server
+    };
+
+    typedef boost::shared_ptr<registry> registry_ptr;
+
+    class session : public boost::enable_shared_from_this<session> {
+
+    public: // methods
+
+        session( boost::asio::io_service& io, sink_type s, registry_ptr r, size_t max_frame ) :
+            strand_(io),
+            socket_(io),
+            sink_(s),
+            registry_(r),
+            max_frame_(max_frame)
+        {
+        }
+
+        socket_type& socket() { return socket_; }
+
+        void read()
+        {
+            socket_.async_read_some( boost::asio::buffer( chunk_, sizeof(chunk_) ),
+                                     strand_.wrap( boost::bind( &session::on_read, this->shared_from_this(),
+                                                                boost::asio::placeholders::error,
+                                                                boost::asio::placeholders::bytes_transferred ) ) );
+        }
+
+        /// Closes the connection from any thread, through the strand of the reads
+        void close()
+        {
+            strand_.post( boost::bind( &session::shutdown, this->shared_from_this() ) );
+        }
+
+    protected: // methods
+
+        void shutdown()
+        {
+            boost::system::error_code ignored;
+            socket_.close( ignored );
+        }
+
+        void on_read( const boost::system::error_code& ec, size_t n )
+        {
+            if( ec )
+                return; // closed by the peer or the server, the session ends with the last reference
+
+            buf_.append( chunk_, n );
+
+            size_t pos = 0;
+            size_t nb  = 0;
+            try
+            {
+                while( buf_.size() - pos >= detail::frame_header )
+                {
+                    size_t len = detail::get_length( buf_.data() + pos );
+                    if( len > max_frame_ )
+                        throw RemoteServer<M,Protocol>::Exception();
+                    if( buf_.size() - pos - detail::frame_header < len )
+                        break; // incomplete frame
+
+                    sink_->send( wire_traits<M>::decode( buf_.data() + pos + detail::frame_header, len ) );
+                    ++nb;
+
+                    pos += detail::frame_header + len;
+                }
+            }
+            catch(...)
+            {
+                count( nb );
+                shutdown(); // undecodable stream, drop the connection
+                return;
+            }
+
+            count( nb );
+            buf_.erase( 0, pos );
+
+            read();
+        }
+
+        void count( size_t nb )
+        {
+            boost::lock_guard<boost::mutex> lock( registry_->m );
+            registry_->received += nb;
+        }
+
+    protected: // data
+
+        boost::asio::io_service::strand strand_;  ///< serializes the reads and the close
+        socket_type               socket_;
+        sink_type                 sink_;
+        registry_ptr              registry_;
+        size_t                    max_frame_;        ///< max bytes of a frame, without its header
+
+        char                      chunk_[64*1024];   ///< read buffer
+        std::string               buf_;              ///< bytes of incomplete frames, at most a frame and a chunk
+    };
+
+protected: // data
+
+    boost::asio::io_service&  io_;
+    acceptor_type             acceptor_;      ///< accepts the connections of the proxies
+
+    sink_type                 sink_;          ///< local destination of the messages
+    size_t                    max_frame_;     ///< max bytes of a frame, without its header
+
+    registry_ptr              registry_;      ///< counters and sessions, also held by the handlers
+
+public: // methods
+
+    /// Constructor
+    /// Starts accepting connections, throws boost::system::system_error on failure
+    /// @param max_frame is the max size of an encoded message
+    RemoteServer( boost::asio::io_service& io, const endpoint_type& ep, sink_type s, size_t max_frame = 16 * 1024 * 1024 ) :
+        io_(io),
+        acceptor_(io, ep),
+        sink_(s),
+        max_frame_(max_frame),
+        registry_( new registry() )
+    {
+        boost::lock_guard<boost::mutex> lock( registry_->m );
+        accept();
+    }
+
+    /// Destructor
+    /// Stops accepting and closes the established connections
+    ~RemoteServer()
+    {
+        std::vector< boost::weak_ptr<session> > sessions;
+        {
+            boost::lock_guard<boost::mutex> lock( registry_->m );
+            registry_->closed = true;
+            boost::system::error_code ignored;
+            acceptor_.close( ignored );
+            sessions.swap( registry_->sessions );
+        }
+
+        for( size_t i = 0; i < sessions.size(); ++i )
+            if( session_ptr s = sessions[i].lock() )
+                s->close();
+    }
+
+    /// Stops accepting connections, the established ones end when closed by the proxies
+    void close()
+    {
+        boost::lock_guard<boost::mutex> lock( registry_->m );
+        boost::system::error_code ignored;
+        acceptor_.close( ignored );
+    }
+
+    /// @returns the nb of messages received
+    size_t received() const
+    {
+        boost::lock_guard<boost::mutex> lock( registry_->m );
+        return registry_->received;
+    }
+
+    /// @returns the endpoint the server listens on, e.g. to find the port chosen by the system
+    endpoint_type endpoint() const { return acceptor_.local_endpoint(); }
+
+    /// Factory method
+    static RemoteServer<M,Protocol>::Ptr create( boost::asio::io_service& io, const endpoint_type& ep, sink_type s, size_t max_frame = 16 * 1024 * 1024 )
+    {
+        return RemoteServer<M,Protocol>::Ptr( new RemoteServer<M,Protocol>(io,ep,s,max_frame) );
+    }
+
+protected: // methods
+
+    /// Starts the next accept, must be called with the registry locked
+    void accept()
+    {
+        session_ptr s( new session( io_, sink_, registry_, max_frame_ ) );
+        acceptor_.async_accept( s->socket(),
+                                boost::bind( &RemoteServer<M,Protocol>::accepted, this, registry_, s,
+                                             boost::asio::placeholders::error ) );
+    }
+
+    /// Static, the server may be gone: it is only used while the registry says it is not
+    static void accepted( RemoteServer<M,Protocol>* server, registry_ptr r, session_ptr s, const boost::system::error_code& ec )
+    {
+        if( ec )
+            return; // acceptor closed
+
+        boost::lock_guard<boost::mutex> lock( r->m );
+        if( r->closed )
+            return;
+
+        // forget the sessions that ended, so the list only grows with the live ones
+
+        std::vector< boost::weak_ptr<session> >& ss = r->sessions;
+        ss.erase( std::remove_if( ss.begin(), ss.end(), boost::bind( &boost::weak_ptr<session>::expired, _1 ) ), ss.end() );
+        ss.push_back(s);
+
+        s->read();
+        server->accept();
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,267 @@
+#ifndef ResultCache_h
+#define ResultCache_h
+
+#define BOOST_THREAD_VERSION 3
+
+#include <algorithm>
+#include <list>
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/chrono.hpp>
+#include <boost/function.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/thread/mutex.hpp>
+
+//-----------------------------------------------------------------------------
+
+/// Hit and miss counters of a cache, independent of its types
+/// Atomic, so counting does not serialize lookups in different shards
+class CacheCounters : private boost::noncopyable {
+
+public: // methods
+
+    CacheCounters() : hits_(0), misses_(0) {}
+
+    virtual ~CacheCounters() {}
+
+    /// @returns nb of lookups that found a valid entry
+    size_t hits() const { return hits_.load( boost::memory_order_relaxed ); }
+
+    /// @returns nb of lookups that found no entry or an expired one
+    size_t misses() const { return misses_.load( boost::memory_order_relaxed ); }
+
+protected: // methods
+
+    void count( bool hit )
+    {
+        if( hit )
+            hits_.fetch_add( 1, boost::memory_order_relaxed );
+        else
+            misses_.fetch_add( 1, boost::memory_order_relaxed );
+    }
+
+private: // data
+
+    boost::atomic<size_t> hits_;
+    boost::atomic<size_t> misses_;
+
+};
+
+//-----------------------------------------------------------------------------
+
+/// Concurrent cache of results, with LRU eviction, entry and byte budgets and time to live
+///
+/// Keys are spread over shards, each with its own lock and LRU list,
+/// so concurrent lookups of different keys rarely contend.
+/// The budgets are split evenly among the shards.
+
+template < typename K, typename V >
+class ResultCache : public CacheCounters {
+
+public: // types
+
+    typedef boost::shared_ptr< ResultCache<K,V> > Ptr;
+
+    typedef K key_type;
+    typedef V value_type;
+
+    typedef boost::chrono::steady_clock  clock_type;
+    typedef clock_type::duration         duration;
+
+    /// @returns the nb of bytes accounted for an entry
+    typedef boost::function< size_t ( const K&, const V& ) > sizer_type;
+
+protected: // types
+
+    struct entry
+    {
+        entry( const K& k, const V& v, size_t b, clock_type::time_point t ) :
+            key(k), value(v), bytes(b), expires(t) {}
+
+        K                       key;
+        V                       value;
+        size_t                  bytes;
+        clock_type::time_point  expires;
+    };
+
+    typedef std::list< entry >                                        list_type;
+    typedef boost::unordered_map< K, typename list_type::iterator >   index_type;
+
+    struct shard
+    {
+        shard() : bytes(0) {}
+
+        boost::mutex m;
+        list_type    lru;     ///< most recently used at the front
+        index_type   index;
+        size_t       bytes;
+    };
+
+protected: // data
+
+    size_t                max_entries_;   ///< max entries per shard, 0 is unlimited
+    size_t                max_bytes_;     ///< max bytes per shard, 0 is unlimited
+    duration              ttl_;           ///< time to live of an entry, 0 is forever
+
+    sizer_type            sizer_;         ///< accounts the bytes of each entry
+
+    std::vector< boost::shared_ptr<shard> > shards_;
+
+public: // methods
+
+    /// Constructor
+    /// @param max_entries is the max nb of entries, 0 is unlimited
+    /// @param max_bytes is the max nb of bytes, as accounted by the sizer, 0 is unlimited
+    /// @param ttl is how long an entry stays valid, 0 is forever
+    /// @param nb_shards is the nb of independently locked partitions
+    /// @param sizer returns the bytes of an entry, by default sizeof(K) + sizeof(V)
+    ResultCache( size_t max_entries,
+                 size_t max_bytes = 0,
+                 duration ttl = duration::zero(),
+                 size_t nb_shards = 16,
+                 sizer_type sizer = sizer_type() ) :
+        ttl_(ttl),
+        sizer_(sizer)
+    {
+        if( !nb_shards )
+            nb_shards = 1;
+
+        max_entries_ = max_entries ? std::max<size_t>( max_entries / nb_shards, 1 ) : 0;
+        max_bytes_   = max_bytes   ? std::max<size_t>( max_bytes   / nb_shards, 1 ) : 0;
+
+        for( size_t i = 0; i < nb_shards; ++i )
+            shards_.push_back( boost::shared_ptr<shard>( new shard() ) );
+    }
+
+    /// Looks up a key, refreshing its position in the LRU
+    /// @returns true if a valid entry was found and copied to v
+    bool get( const K& k, V& v )
+    {
+        shard& s = shard_of(k);
+        bool hit = false;
+        {
+            boost::lock_guard<boost::mutex> lock(s.m);
+
+            typename index_type::iterator itr = s.index.find(k);
+            if( itr != s.index.end() )
+            {
+                typename list_type::iterator e = itr->second;
+                if( ttl_ != duration::zero() && e->expires <= clock_type::now() )
+                {
+                    erase( s, e );
+                }
+                else
+                {
+                    s.lru.splice( s.lru.begin(), s.lru, e );
+                    v = e->value;
+                    hit = true;
+                }
+            }
+        }
+        count( hit );
+        return hit;
+    }
+
+    /// Inserts or replaces an entry, evicting the least recently used ones to fit the budgets
+    void put( const K& k, const V& v )
+    {
+        size_t bytes = sizer_ ? sizer_(k,v) : sizeof(K) + sizeof(V);
+        clock_type::time_point expires = ttl_ != duration::zero() ? clock_type::now() + ttl_ : clock_type::time_point();
+
+        shard& s = shard_of(k);
+
+        boost::lock_guard<boost::mutex> lock(s.m);
+
+        typename index_type::iterator itr = s.index.find(k);
+        if( itr != s.index.end() )
+            erase( s, itr->second );
+
+        if( max_bytes_ && bytes > max_bytes_ ) // would never fit
+            return;
+
+        s.lru.push_front( entry( k, v, bytes, expires ) );
+        s.index[k] = s.lru.begin();
+        s.bytes += bytes;
+
+        while( ( max_entries_ && s.index.size() > max_entries_ ) || ( max_bytes_ && s.bytes > max_bytes_ ) )
+            erase( s, --s.lru.end() );
+    }
+
+    /// Executes the function and caches its result
+    /// @returns the result
+    V compute( boost::function< V ( K ) > f, K k )
+    {
+        V v = f(k);
+        put( k, v );
+        return v;
+    }
+
+    /// Removes all entries
+    void clear()
+    {
+        for( size_t i = 0; i < shards_.size(); ++i )
+        {
+            boost::lock_guard<boost::mutex> lock( shards_[i]->m );
+            shards_[i]->lru.clear();
+            shards_[i]->index.clear();
+            shards_[i]->bytes = 0;
+        }
+    }
+
+    /// @returns the nb of entries
+    size_t size() const
+    {
+        size_t n = 0;
+        for( size_t i = 0; i < shards_.size(); ++i )
+        {
+            boost::lock_guard<boost::mutex> lock( shards_[i]->m );
+            n += shards_[i]->index.size();
+        }
+        return n;
+    }
+
+    /// @returns the nb of bytes accounted
+    size_t bytes() const
+    {
+        size_t n = 0;
+        for( size_t i = 0; i < shards_.size(); ++i )
+        {
+            boost::lock_guard<boost::mutex> lock( shards_[i]->m );
+            n += shards_[i]->bytes;
+        }
+        return n;
+    }
+
+    /// Factory method
+    static ResultCache<K,V>::Ptr create( size_t max_entries,
+                                         size_t max_bytes = 0,
+                                         duration ttl = duration::zero(),
+                                         size_t nb_shards = 16,
+                                         sizer_type sizer = sizer_type() )
+    {
+        return ResultCache<K,V>::Ptr( new ResultCache<K,V>(max_entries,max_bytes,ttl,nb_shards,sizer) );
+    }
+
+protected: // methods
+
+    shard& shard_of( const K& k )
+    {
+        return *shards_[ boost::hash<K>()(k) % shards_.size() ];
+    }
+
+    void erase( shard& s, typename list_type::iterator e )
+    {
+        s.bytes -= e->bytes;
+        s.index.erase( e->key );
+        s.lru.erase( e );
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
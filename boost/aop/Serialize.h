@@ -0,0 +1,312 @@
+#ifndef Serialize_h
+#define Serialize_h
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/predef/other/endian.h>
+#include <boost/utility/enable_if.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+#include <boost/type_traits/is_floating_point.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/type_traits/is_pod.hpp>
+#include <boost/type_traits/is_signed.hpp>
+
+//-----------------------------------------------------------------------------
+
+/// Appends the binary encoding of values to a string
+class BinaryWriter {
+
+public: // methods
+
+    BinaryWriter( std::string& out ) : out_(out) {}
+
+    /// Appends raw bytes
+    void bytes( const void* p, size_t n )
+    {
+        out_.append( static_cast<const char*>(p), n );
+    }
+
+    /// Appends an unsigned integer in 7 bit groups, small values take fewer bytes
+    void varint( boost::uint64_t v )
+    {
+        char buf[10];
+        size_t n = 0;
+        while( v >= 0x80 )
+        {
+            buf[n++] = char( ( v & 0x7f ) | 0x80 );
+            v >>= 7;
+        }
+        buf[n++] = char(v);
+        out_.append( buf, n );
+    }
+
+    /// @returns the output
+    std::string& str() { return out_; }
+
+private: // data
+
+    std::string& out_;
+
+};
+
+//-----------------------------------------------------------------------------
+
+/// Reads back what a BinaryWriter wrote, throws Exception on truncated or corrupt input
+class BinaryReader {
+
+public: // types
+
+    class Exception {};
+
+public: // methods
+
+    BinaryReader( const char* p, size_t n ) : p_(p), end_(p + n) {}
+
+    /// Copies raw bytes out
+    void bytes( void* p, size_t n )
+    {
+        if( size_t( end_ - p_ ) < n )
+            throw BinaryReader::Exception();
+        std::memcpy( p, p_, n );
+        p_ += n;
+    }
+
+    /// @returns a pointer to the next n bytes, and skips them
+    const char* skip( size_t n )
+    {
+        if( size_t( end_ - p_ ) < n )
+            throw BinaryReader::Exception();
+        const char* p = p_;
+        p_ += n;
+        return p;
+    }
+
+    boost::uint64_t varint()
+    {
+        boost::uint64_t v = 0;
+        for( unsigned shift = 0; shift < 64; shift += 7 )
+        {
+            if( p_ == end_ )
+                throw BinaryReader::Exception();
+            unsigned char c = *p_++;
+            v |= boost::uint64_t( c & 0x7f ) << shift;
+            if( !( c & 0x80 ) )
+                return v;
+        }
+        throw BinaryReader::Exception(); // more than 10 bytes
+    }
+
+    /// @returns the nb of bytes not yet read
+    size_t remaining() const { return end_ - p_; }
+
+private: // data
+
+    const char* p_;
+    const char* end_;
+
+};
+
+//-----------------------------------------------------------------------------
+
+/// How a type is written and read in binary, specialize for your own types
+///
+/// Provided are integers as varints (signed ones zigzag encoded, so small negatives stay short),
+/// float and double as their IEEE 754 bytes in little endian order, strings, vectors and pairs.
+/// Other types, pointers and enums included, do not compile until given binary_traits or binary_raw.
+
+template < typename T, typename Enable = void >
+struct binary_traits;
+
+/// Specialize as true for a POD type to be copied as its bytes in host layout
+/// The encoding is then only readable by peers of the same architecture and compiler
+template < typename T >
+struct binary_raw : boost::false_type {};
+
+/// True for float and double, which are encoded as their bytes in a defined order
+template < typename T >
+struct binary_float : boost::integral_constant< bool,
+    boost::is_floating_point<T>::value && std::numeric_limits<T>::is_iec559 && sizeof(T) <= sizeof(double) > {};
+
+/// True if the encoding of T is its bytes in memory, so vectors of T are copied at once
+template < typename T >
+struct binary_flat : boost::integral_constant< bool,
+    binary_raw<T>::value || ( binary_float<T>::value && BOOST_ENDIAN_LITTLE_BYTE ) > {};
+
+template < typename T >
+struct binary_traits< T, typename boost::enable_if< boost::is_integral<T> >::type >
+{
+    static void write( BinaryWriter& w, const T& v )
+    {
+        if( boost::is_signed<T>::value )
+            w.varint( zigzag( boost::int64_t(v) ) );
+        else
+            w.varint( boost::uint64_t(v) );
+    }
+
+    /// Throws BinaryReader::Exception if the value does not fit in T
+    static void read( BinaryReader& r, T& v )
+    {
+        boost::uint64_t u = r.varint();
+        if( boost::is_signed<T>::value )
+        {
+            boost::int64_t n = boost::int64_t( u >> 1 ) ^ -boost::int64_t( u & 1 );
+            v = T(n);
+            if( boost::int64_t(v) != n )
+                throw BinaryReader::Exception();
+        }
+        else
+        {
+            v = T(u);
+            if( boost::uint64_t(v) != u )
+                throw BinaryReader::Exception();
+        }
+    }
+
+    static boost::uint64_t zigzag( boost::int64_t n )
+    {
+        return ( boost::uint64_t(n) << 1 ) ^ boost::uint64_t( n >> 63 );
+    }
+};
+
+/// Little endian like the frame lengths, so the bytes are only swapped on big endian hosts
+template < typename T >
+struct binary_traits< T, typename boost::enable_if< binary_float<T> >::type >
+{
+    static void write( BinaryWriter& w, const T& v )
+    {
+        char b[sizeof(T)];
+        std::memcpy( b, &v, sizeof(T) );
+        order( b );
+        w.bytes( b, sizeof(T) );
+    }
+
+    static void read( BinaryReader& r, T& v )
+    {
+        char b[sizeof(T)];
+        r.bytes( b, sizeof(T) );
+        order( b );
+        std::memcpy( &v, b, sizeof(T) );
+    }
+
+    /// Converts between host and little endian order, both ways
+    static void order( char* b )
+    {
+        if( !BOOST_ENDIAN_LITTLE_BYTE )
+            std::reverse( b, b + sizeof(T) );
+    }
+};
+
+/// Opted in fast path, the bytes are copied as they are in memory
+template < typename T >
+struct binary_traits< T, typename boost::enable_if< binary_raw<T> >::type >
+{
+    BOOST_STATIC_ASSERT( boost::is_pod<T>::value );
+
+    static void write( BinaryWriter& w, const T& v ) { w.bytes( &v, sizeof(T) ); }
+    static void read( BinaryReader& r, T& v )        { r.bytes( &v, sizeof(T) ); }
+};
+
+template <>
+struct binary_traits< std::string >
+{
+    static void write( BinaryWriter& w, const std::string& s )
+    {
+        w.varint( s.size() );
+        w.bytes( s.data(), s.size() );
+    }
+
+    static void read( BinaryReader& r, std::string& s )
+    {
+        boost::uint64_t n = r.varint();
+        if( n > r.remaining() )
+            throw BinaryReader::Exception();
+        s.assign( r.skip(n), size_t(n) );
+    }
+};
+
+template < typename T1, typename T2 >
+struct binary_traits< std::pair<T1,T2> >
+{
+    static void write( BinaryWriter& w, const std::pair<T1,T2>& p )
+    {
+        binary_traits<T1>::write( w, p.first );
+        binary_traits<T2>::write( w, p.second );
+    }
+
+    static void read( BinaryReader& r, std::pair<T1,T2>& p )
+    {
+        binary_traits<T1>::read( r, p.first );
+        binary_traits<T2>::read( r, p.second );
+    }
+};
+
+template < typename T >
+struct binary_traits< std::vector<T> >
+{
+    static void write( BinaryWriter& w, const std::vector<T>& v )
+    {
+        w.varint( v.size() );
+        if( fixed && !v.empty() ) // one copy for the whole vector
+            w.bytes( &v[0], v.size() * sizeof(T) );
+        else
+            for( size_t i = 0; i < v.size(); ++i )
+                binary_traits<T>::write( w, v[i] );
+    }
+
+    static void read( BinaryReader& r, std::vector<T>& v )
+    {
+        boost::uint64_t n = r.varint();
+        if( fixed )
+        {
+            if( n > r.remaining() / sizeof(T) ) // before multiplying, which could overflow
+                throw BinaryReader::Exception();
+            const char* p = r.skip( n * sizeof(T) );
+            v.resize(n);
+            if( n )
+                std::memcpy( &v[0], p, n * sizeof(T) );
+        }
+        else
+        {
+            if( n > r.remaining() ) // each element takes at least a byte
+                throw BinaryReader::Exception();
+            v.resize(n);
+            for( size_t i = 0; i < n; ++i )
+                binary_traits<T>::read( r, v[i] );
+        }
+    }
+
+    static const bool fixed = binary_flat<T>::value;
+};
+
+//-----------------------------------------------------------------------------
+
+/// Appends the binary encoding of a value
+template < typename T >
+void binary_encode( const T& v, std::string& out )
+{
+    BinaryWriter w(out);
+    binary_traits<T>::write( w, v );
+}
+
+/// @returns the value decoded from n bytes, throws BinaryReader::Exception if they are not a valid encoding
+template < typename T >
+T binary_decode( const char* p, size_t n )
+{
+    BinaryReader r(p,n);
+    T v;
+    binary_traits<T>::read( r, v );
+    if( r.remaining() )
+        throw BinaryReader::Exception(); // trailing garbage
+    return v;
+}
+
+//-----------------------------------------------------------------------------
+
+#endif
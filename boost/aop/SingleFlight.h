@@ -0,0 +1,128 @@
+#ifndef SingleFlight_h
+#define SingleFlight_h
+
+#define BOOST_THREAD_VERSION 3
+
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/future.hpp>
+
+//-----------------------------------------------------------------------------
+
+/// Counters of a SingleFlight, independent of its types
+class FlightCounters : private boost::noncopyable {
+
+public: // methods
+
+    FlightCounters() : joined_(0) {}
+
+    virtual ~FlightCounters() {}
+
+    /// @returns nb of requests that shared the execution of an identical one
+    size_t joined() const
+    {
+        boost::lock_guard<boost::mutex> lock(fm_);
+        return joined_;
+    }
+
+protected: // data
+
+    mutable boost::mutex fm_;   ///< mutex for the flights and counters
+
+    size_t joined_;
+
+};
+
+//-----------------------------------------------------------------------------
+
+/// Registry of the requests in flight, so identical concurrent requests share one execution
+///
+/// The first request for a key becomes the leader and gets to execute,
+/// the others only attach their promise. When the leader lands, it takes
+/// all the attached promises and fulfills them with its single result.
+
+template < typename K, typename R >
+class SingleFlight : public FlightCounters {
+
+public: // types
+
+    typedef boost::shared_ptr< SingleFlight<K,R> > Ptr;
+
+    class Exception {}; ///< set on the promises of an aborted flight
+
+    typedef boost::shared_ptr< boost::promise<R> > promise_ptr;
+
+    typedef std::vector< promise_ptr > promises_type;
+
+protected: // data
+
+    boost::unordered_map< K, promises_type > flights_;  ///< promises waiting per key
+
+public: // methods
+
+    /// Attaches a promise to the flight for the key, starting the flight if there is none
+    /// @returns true if the caller leads a new flight and must execute the request
+    bool join( const K& k, const promise_ptr& p )
+    {
+        boost::lock_guard<boost::mutex> lock(fm_);
+
+        typename boost::unordered_map< K, promises_type >::iterator itr = flights_.find(k);
+        if( itr != flights_.end() )
+        {
+            itr->second.push_back(p);
+            ++joined_;
+            return false;
+        }
+
+        flights_[k].push_back(p);
+        return true;
+    }
+
+    /// Ends the flight for the key, later requests start a new one
+    /// @returns the promises of all requests in the flight
+    promises_type land( const K& k )
+    {
+        promises_type prs;
+
+        boost::lock_guard<boost::mutex> lock(fm_);
+
+        typename boost::unordered_map< K, promises_type >::iterator itr = flights_.find(k);
+        if( itr != flights_.end() )
+        {
+            prs.swap( itr->second );
+            flights_.erase( itr );
+        }
+        return prs;
+    }
+
+    /// Ends the flight for the key without a result, the promises hold an Exception
+    void abort( const K& k )
+    {
+        promises_type prs = land(k);
+        for( size_t i = 0; i < prs.size(); ++i )
+            prs[i]->set_exception( boost::copy_exception( SingleFlight<K,R>::Exception() ) );
+    }
+
+    /// @returns nb of flights in the air
+    size_t size() const
+    {
+        boost::lock_guard<boost::mutex> lock(fm_);
+        return flights_.size();
+    }
+
+    /// Factory method
+    static SingleFlight<K,R>::Ptr create()
+    {
+        return SingleFlight<K,R>::Ptr( new SingleFlight<K,R>() );
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
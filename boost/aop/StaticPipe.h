@@ -0,0 +1,305 @@
+#ifndef StaticPipe_h
+#define StaticPipe_h
+
+#define BOOST_THREAD_VERSION 3
+
+#include <boost/bind.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "Active.h"
+
+//-----------------------------------------------------------------------------
+
+/// Pipelines whose stages know each other's concrete type
+///
+/// stage<M,R>(f) | stage<R,S>(g) | ... only describes the pipeline, it is then built
+/// with make_static_pipe. Each stage owns its queue and threads like an Active, but holds
+/// the next stage by value and hands results over with a plain, inlinable call:
+/// no virtual send, no shared_ptr copies and no type erasure between stages.
+/// The runtime sees the pipeline only at its edges, through StaticEntry and exit_to(sink).
+
+//-----------------------------------------------------------------------------
+
+/// Description of a stage
+template < typename M, typename R, typename F >
+struct StageSpec
+{
+    typedef M message_type;
+    typedef R result_type;
+
+    StageSpec( F x, size_t t, size_t q ) : f(x), nb_threads(t), qsize(q) {}
+
+    F      f;
+    size_t nb_threads;
+    size_t qsize;
+};
+
+/// Description of a pipeline ending in a runtime sink
+template < typename R >
+struct ExitSpec
+{
+    typedef R message_type;
+
+    ExitSpec( const typename IActive<R>::Ptr& s ) : sink(s) {}
+
+    typename IActive<R>::Ptr sink;
+};
+
+/// Description of a pipeline that discards the results of its last stage
+struct EndSpec {};
+
+/// Description of a pipeline, a stage followed by the rest
+template < typename Head, typename Tail = EndSpec >
+struct ChainSpec
+{
+    typedef typename Head::message_type message_type;
+
+    ChainSpec( const Head& h, const Tail& t = Tail() ) : head(h), tail(t) {}
+
+    Head head;
+    Tail tail;
+};
+
+/// @returns the description of a stage executing f on M to produce R
+template < typename M, typename R, typename F >
+ChainSpec< StageSpec<M,R,F> > stage( F f, size_t nb_threads = 1, size_t qsize = 0 )
+{
+    return ChainSpec< StageSpec<M,R,F> >( StageSpec<M,R,F>( f, nb_threads, qsize ) );
+}
+
+/// @returns the description of the edge handing results back to the runtime
+template < typename R >
+ExitSpec<R> exit_to( const boost::shared_ptr< IActive<R> >& sink )
+{
+    return ExitSpec<R>( sink );
+}
+
+//-----------------------------------------------------------------------------
+
+namespace detail {
+
+/// Appends a description to the end of a chain
+template < typename Chain, typename Last >
+struct Append;
+
+template < typename Head, typename Last >
+struct Append< ChainSpec<Head,EndSpec>, Last >
+{
+    typedef ChainSpec<Head,Last> type;
+
+    static type apply( const ChainSpec<Head,EndSpec>& c, const Last& l ) { return type( c.head, l ); }
+};
+
+template < typename Head, typename Tail, typename Last >
+struct Append< ChainSpec<Head,Tail>, Last >
+{
+    typedef ChainSpec< Head, typename Append<Tail,Last>::type > type;
+
+    static type apply( const ChainSpec<Head,Tail>& c, const Last& l ) { return type( c.head, Append<Tail,Last>::apply( c.tail, l ) ); }
+};
+
+/// Hands the result of a stage to the next one
+template < typename R >
+struct Forward
+{
+    template < typename F, typename M, typename Next >
+    static void apply( F& f, const M& m, Next& next ) { next.send( f(m) ); }
+};
+
+template <>
+struct Forward<void>
+{
+    template < typename F, typename M, typename Next >
+    static void apply( F& f, const M& m, Next& ) { f(m); }
+};
+
+}
+
+/// Chains two descriptions
+template < typename H1, typename T1, typename Next >
+typename detail::Append< ChainSpec<H1,T1>, Next >::type
+operator| ( const ChainSpec<H1,T1>& c, const Next& n )
+{
+    return detail::Append< ChainSpec<H1,T1>, Next >::apply( c, n );
+}
+
+//-----------------------------------------------------------------------------
+
+/// Last stage discarding results
+class StaticEnd : private boost::noncopyable {
+
+public: // methods
+
+    StaticEnd( const EndSpec& ) {}
+
+    template < typename T >
+    void send( const T& ) {}
+
+};
+
+/// Last stage handing results to the runtime
+template < typename R >
+class StaticExit : private boost::noncopyable {
+
+public: // methods
+
+    StaticExit( const ExitSpec<R>& s ) : sink_(s.sink) {}
+
+    void send( const R& r ) { sink_->send( r ); }
+
+private: // data
+
+    typename IActive<R>::Ptr sink_;
+
+};
+
+//-----------------------------------------------------------------------------
+
+/// Builds the concrete type of a described pipeline
+template < typename Spec >
+struct static_pipe_of;
+
+template < typename M, typename R, typename F, typename Next >
+class StaticStage;
+
+template <>
+struct static_pipe_of< EndSpec > { typedef StaticEnd type; };
+
+template < typename R >
+struct static_pipe_of< ExitSpec<R> > { typedef StaticExit<R> type; };
+
+template < typename M, typename R, typename F, typename Tail >
+struct static_pipe_of< ChainSpec< StageSpec<M,R,F>, Tail > >
+{
+    typedef StaticStage< M, R, F, typename static_pipe_of<Tail>::type > type;
+};
+
+//-----------------------------------------------------------------------------
+
+/// Stage of a static pipeline, with its own queue and threads
+/// Holds the next stage by value, so destroying the pipeline drains it front to back
+
+template < typename M, typename R, typename F, typename Next >
+class StaticStage : private boost::noncopyable {
+
+public: // types
+
+    typedef M message_type;
+    typedef R result_type;
+
+    class Exception {};
+
+protected: // data
+
+    F                     exec_;      ///< function to handle each message
+
+    Next                  next_;      ///< next stage, receives the results
+
+    message_queue<M>      mq_;        ///< message queue
+
+    bool                  done_;      ///< flag for finishing
+
+    boost::thread_group   threads_;   ///< worker threads
+
+public: // methods
+
+    /// Constructor
+    /// Builds this stage and the following ones from the description
+    template < typename Tail >
+    StaticStage( const ChainSpec< StageSpec<M,R,F>, Tail >& c ) :
+        exec_(c.head.f),
+        next_(c.tail),
+        mq_(c.head.qsize),
+        done_(false)
+    {
+        for( size_t i = 0; i < c.head.nb_threads; ++i )
+            threads_.create_thread( boost::bind( &StaticStage::run, this ) );
+    }
+
+    /// Destructor
+    /// Waits for the queue to drain, then the next stage drains as it is destroyed
+    ~StaticStage()
+    {
+        mq_.drain_and_close();
+        done_ = true;
+        threads_.join_all();
+    }
+
+    /// Enqueues a message
+    void send( const message_type& msg )
+    {
+        if( ! mq_.wait_and_push( msg ) )
+            throw StaticStage::Exception();
+    }
+
+    /// @returns the current queue size
+    size_t qsize() { return mq_.size(); }
+
+    /// @returns the next stage
+    Next& next() { return next_; }
+
+protected: // methods
+
+    void run()
+    {
+        message_type m;
+        while (!done_)
+        {
+            try
+            {
+                if( mq_.try_and_pop(m) )
+                    detail::Forward<R>::apply( exec_, m, next_ );
+                else
+                    boost::this_thread::yield();
+            }
+            catch ( boost::thread_interrupted& e )
+            {
+                break; //< finish this thread
+            }
+        }
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+
+/// Builds a pipeline from its description
+template < typename Spec >
+boost::shared_ptr< typename static_pipe_of<Spec>::type > make_static_pipe( const Spec& s )
+{
+    return boost::shared_ptr< typename static_pipe_of<Spec>::type >( new typename static_pipe_of<Spec>::type( s ) );
+}
+
+/// Entry edge, so the runtime can send to a static pipeline as to any IActive
+template < typename Pipeline >
+class StaticEntry : public IActive< typename Pipeline::message_type > {
+
+public: // types
+
+    typedef boost::shared_ptr< StaticEntry<Pipeline> > Ptr;
+
+    typedef typename Pipeline::message_type message_type;
+
+public: // methods
+
+    StaticEntry( const boost::shared_ptr<Pipeline>& p ) : pipeline_(p) {}
+
+    virtual void send( message_type msg ) { pipeline_->send( msg ); }
+
+    /// Factory method
+    static StaticEntry<Pipeline>::Ptr create( const boost::shared_ptr<Pipeline>& p )
+    {
+        return StaticEntry<Pipeline>::Ptr( new StaticEntry<Pipeline>(p) );
+    }
+
+private: // data
+
+    boost::shared_ptr<Pipeline> pipeline_;
+
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
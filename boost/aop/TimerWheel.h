@@ -0,0 +1,366 @@
+#ifndef TimerWheel_h
+#define TimerWheel_h
+
+#define BOOST_THREAD_VERSION 3
+
+#include <algorithm>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/chrono.hpp>
+
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+//-----------------------------------------------------------------------------
+
+/// Hierarchical timing wheel driven by a single thread
+///
+/// Four levels of 256 slots, each level counting in units of the slots of the level below.
+/// Scheduling and cancelling are O(1); timers expiring past the lowest level
+/// cascade down one level each time the level below wraps around.
+/// Callbacks run on the timer thread, so they should only hand work off without blocking
+/// (e.g. Active::try_send). Exceptions they throw are counted in failed().
+
+class TimerWheel : private boost::noncopyable {
+
+public: // types
+
+    typedef boost::shared_ptr< TimerWheel > Ptr;
+
+    typedef boost::chrono::steady_clock  clock_type;
+    typedef clock_type::time_point       time_point;
+    typedef clock_type::duration         duration;
+
+    typedef boost::function< void () >   callback_type;
+
+    /// Identifies a scheduled timer, 0 is never a valid id
+    typedef boost::uint64_t              TimerId;
+
+protected: // types
+
+    typedef boost::uint64_t tick_type;
+
+    enum { LEVELS = 4, SLOT_BITS = 8, SLOTS = 1 << SLOT_BITS, SLOT_MASK = SLOTS - 1 };
+
+    static const boost::int32_t NIL = -1;
+
+    /// Timer storage, kept in a pool and linked into the slots by index
+    struct entry
+    {
+        entry() : expires(0), prev(NIL), next(NIL), generation(1), slot(NIL) {}
+
+        tick_type       expires;      ///< tick at which the timer fires
+        callback_type   callback;     ///< action to run
+        boost::int32_t  prev;         ///< previous entry in slot list
+        boost::int32_t  next;         ///< next entry in slot or free list
+        boost::uint32_t generation;   ///< incremented on release, invalidates old ids
+        boost::int32_t  slot;         ///< LEVELS * SLOTS index of the slot, NIL if not linked
+    };
+
+protected: // data
+
+    mutable boost::mutex      m_;             ///< mutex for the wheel
+    boost::condition_variable wakeup_cond_;   ///< wakes the timer thread when idle
+
+    bool                      done_;          ///< flag for finishing
+
+    duration                  tick_;          ///< resolution of the wheel
+    time_point                start_;         ///< time of tick 0
+    tick_type                 current_;       ///< next tick to be processed
+
+    std::vector< entry >      pool_;          ///< storage for all timers
+    boost::int32_t            free_;          ///< head of free list in pool_
+    size_t                    size_;          ///< nb of scheduled timers
+    size_t                    failed_;        ///< nb of callbacks that threw
+
+    boost::int32_t            slots_[ LEVELS * SLOTS ]; ///< heads of the slot lists
+
+    boost::thread             thd_;           ///< timer thread
+
+public: // methods
+
+    /// Constructor
+    /// Starts the timer thread
+    /// @param tick is the resolution of the wheel
+    TimerWheel( duration tick = boost::chrono::milliseconds(1) ) :
+        done_(false),
+        tick_(tick),
+        start_( clock_type::now() ),
+        current_(0),
+        free_(NIL),
+        size_(0),
+        failed_(0)
+    {
+        for( size_t i = 0; i < LEVELS * SLOTS; ++i )
+            slots_[i] = NIL;
+
+        thd_ = boost::thread( &TimerWheel::run, this );
+    }
+
+    /// Destructor
+    /// Stops the timer thread, pending timers are discarded
+    ~TimerWheel()
+    {
+        {
+            boost::lock_guard<boost::mutex> lock(m_);
+            done_ = true;
+            wakeup_cond_.notify_one();
+        }
+        thd_.join();
+    }
+
+    /// Schedules a callback at a point in time
+    /// @returns the id to cancel the timer
+    TimerId schedule_at( time_point t, callback_type c )
+    {
+        tick_type expires = t <= start_ ? 0 : ( t - start_ + tick_ - duration(1) ) / tick_; // round up
+
+        boost::lock_guard<boost::mutex> lock(m_);
+
+        if( !size_ ) // wheel was idle, skip the ticks nobody processed
+            current_ = std::max( current_, tick_type( ( clock_type::now() - start_ ) / tick_ ) );
+
+        boost::int32_t i = allocate();
+
+        entry& e = pool_[i];
+        e.expires  = expires;
+        e.callback = c;
+
+        link(i);
+
+        if( ++size_ == 1 )
+            wakeup_cond_.notify_one();
+
+        return make_id( i, e.generation );
+    }
+
+    /// Schedules a callback after a delay
+    /// @returns the id to cancel the timer
+    TimerId schedule_after( duration d, callback_type c )
+    {
+        return schedule_at( clock_type::now() + d, c );
+    }
+
+    /// Cancels a timer
+    /// @returns true if timer was cancelled, false if it already fired or was cancelled
+    bool cancel( TimerId id )
+    {
+        boost::int32_t  i   = boost::int32_t( id & 0xffffffff ) - 1;
+        boost::uint32_t gen = boost::uint32_t( id >> 32 );
+
+        boost::lock_guard<boost::mutex> lock(m_);
+
+        if( i < 0 || size_t(i) >= pool_.size() || pool_[i].generation != gen || pool_[i].slot == NIL )
+            return false;
+
+        unlink(i);
+        release(i);
+        --size_;
+
+        return true;
+    }
+
+    /// @returns the nb of scheduled timers
+    size_t size() const
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        return size_;
+    }
+
+    /// @returns the nb of callbacks that threw, their exceptions are discarded
+    size_t failed() const
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        return failed_;
+    }
+
+    /// @returns the resolution of the wheel
+    duration resolution() const { return tick_; }
+
+    /// Factory method
+    static TimerWheel::Ptr create( duration tick = boost::chrono::milliseconds(1) )
+    {
+        return TimerWheel::Ptr( new TimerWheel(tick) );
+    }
+
+    /// @returns the wheel shared by default by all Active objects
+    static TimerWheel::Ptr instance()
+    {
+        static TimerWheel::Ptr wheel( new TimerWheel() );
+        return wheel;
+    }
+
+protected: // methods
+
+    static TimerId make_id( boost::int32_t i, boost::uint32_t gen )
+    {
+        return ( TimerId(gen) << 32 ) | TimerId( i + 1 );
+    }
+
+    boost::int32_t allocate()
+    {
+        if( free_ == NIL )
+        {
+            pool_.push_back( entry() );
+            return boost::int32_t( pool_.size() - 1 );
+        }
+        boost::int32_t i = free_;
+        free_ = pool_[i].next;
+        return i;
+    }
+
+    void release( boost::int32_t i )
+    {
+        entry& e = pool_[i];
+        e.callback.clear();
+        ++e.generation;
+        e.next = free_;
+        free_ = i;
+    }
+
+    /// Links the entry into the slot corresponding to its distance to current_
+    void link( boost::int32_t i )
+    {
+        entry& e = pool_[i];
+
+        tick_type expires = e.expires < current_ ? current_ : e.expires; // overdue fires on next tick
+        tick_type delta = expires - current_;
+
+        size_t level = 0;
+        while( level < LEVELS - 1 && delta >= ( tick_type(1) << ( SLOT_BITS * ( level + 1 ) ) ) )
+            ++level;
+
+        if( level == LEVELS - 1 ) // beyond the wheel range, will be cascaded again
+        {
+            tick_type max = ( tick_type(1) << ( SLOT_BITS * LEVELS ) ) - 1;
+            if( delta > max )
+                expires = current_ + max;
+        }
+
+        boost::int32_t s = boost::int32_t( level * SLOTS + ( ( expires >> ( SLOT_BITS * level ) ) & SLOT_MASK ) );
+
+        e.slot = s;
+        e.prev = NIL;
+        e.next = slots_[s];
+        if( e.next != NIL )
+            pool_[e.next].prev = i;
+        slots_[s] = i;
+    }
+
+    void unlink( boost::int32_t i )
+    {
+        entry& e = pool_[i];
+
+        if( e.prev != NIL )
+            pool_[e.prev].next = e.next;
+        else
+            slots_[e.slot] = e.next;
+
+        if( e.next != NIL )
+            pool_[e.next].prev = e.prev;
+
+        e.slot = NIL;
+        e.prev = NIL;
+        e.next = NIL;
+    }
+
+    /// Moves all timers of a slot in a higher level to lower levels
+    /// @returns true if the level wrapped around and next level must cascade too
+    bool cascade( size_t level )
+    {
+        size_t idx = ( current_ >> ( SLOT_BITS * level ) ) & SLOT_MASK;
+        boost::int32_t s = boost::int32_t( level * SLOTS + idx );
+
+        boost::int32_t i = slots_[s];
+        slots_[s] = NIL;
+        while( i != NIL )
+        {
+            boost::int32_t next = pool_[i].next;
+            link(i);
+            i = next;
+        }
+
+        return idx == 0;
+    }
+
+    /// Processes one tick, collecting the callbacks of the timers that expired
+    void advance( std::vector< callback_type >& expired )
+    {
+        size_t idx = current_ & SLOT_MASK;
+
+        if( idx == 0 )
+            for( size_t level = 1; level < LEVELS && cascade(level); ++level ) {}
+
+        boost::int32_t i = slots_[idx];
+        slots_[idx] = NIL;
+        while( i != NIL )
+        {
+            entry& e = pool_[i];
+            boost::int32_t next = e.next;
+
+            expired.push_back( callback_type() );
+            expired.back().swap( e.callback );
+
+            e.slot = NIL;
+            release(i);
+            --size_;
+
+            i = next;
+        }
+
+        ++current_;
+    }
+
+    void run()
+    {
+        std::vector< callback_type > expired;
+
+        while( true )
+        {
+            tick_type next;
+
+            {
+                boost::unique_lock<boost::mutex> lock(m_);
+
+                while( !done_ && !size_ )
+                    wakeup_cond_.wait(lock);
+
+                if( done_ )
+                    break;
+
+                tick_type now = ( clock_type::now() - start_ ) / tick_;
+
+                while( current_ <= now && size_ )
+                    advance( expired );
+
+                next = current_;
+            }
+
+            for( size_t i = 0; i < expired.size(); ++i )
+            {
+                try
+                {
+                    expired[i]();
+                }
+                catch(...)
+                {
+                    boost::lock_guard<boost::mutex> lock(m_);
+                    ++failed_;
+                }
+            }
+            expired.clear();
+
+            boost::this_thread::sleep_until( start_ + tick_ * next );
+        }
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
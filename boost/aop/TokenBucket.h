@@ -0,0 +1,72 @@
+#ifndef TokenBucket_h
+#define TokenBucket_h
+
+#include <algorithm>
+
+#include <boost/chrono.hpp>
+
+//-----------------------------------------------------------------------------
+
+/// Token bucket rate limiter
+///
+/// Tokens accumulate at a fixed rate up to the burst size, each admitted item takes one.
+/// Not synchronized, the owner must guard it (e.g. message_queue uses its own mutex).
+
+class TokenBucket {
+
+public: // types
+
+    typedef boost::chrono::steady_clock clock_type;
+
+private: // data
+
+    double                  rate_;      ///< tokens added per second, 0 is unlimited
+    double                  burst_;     ///< max tokens held
+    double                  tokens_;    ///< tokens available
+    clock_type::time_point  last_;      ///< time of last refill
+
+public: // methods
+
+    /// Constructor
+    /// @param rate is the nb of tokens per second, 0 is unlimited
+    /// @param burst is the max nb of tokens taken at once, at least 1
+    TokenBucket( double rate = 0, double burst = 1 ) :
+        rate_(rate),
+        burst_( std::max( burst, 1. ) ),
+        tokens_( burst_ ),
+        last_( clock_type::now() )
+    {
+    }
+
+    /// Takes tokens if available
+    /// @returns true if the tokens were taken
+    bool consume( double n = 1 )
+    {
+        if( !rate_ )
+            return true;
+
+        clock_type::time_point now = clock_type::now();
+        tokens_ = std::min( burst_, tokens_ + rate_ * boost::chrono::duration<double>( now - last_ ).count() );
+        last_ = now;
+
+        if( tokens_ < n )
+            return false;
+
+        tokens_ -= n;
+        return true;
+    }
+
+    /// @returns if the bucket limits the rate
+    bool limited() const { return rate_ != 0; }
+
+    /// @returns the nb of tokens per second
+    double rate() const { return rate_; }
+
+    /// @returns the max nb of tokens taken at once
+    double burst() const { return burst_; }
+
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
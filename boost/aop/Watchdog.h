@@ -0,0 +1,311 @@
+#ifndef Watchdog_h
+#define Watchdog_h
+
+#define BOOST_THREAD_VERSION 3
+
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/chrono.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "Active.h"
+
+//-----------------------------------------------------------------------------
+
+/// Active object as seen by the Watchdog
+class IWatched : private boost::noncopyable {
+
+public: // types
+
+    typedef boost::shared_ptr< IWatched > Ptr;
+
+public: // interface
+
+    virtual ~IWatched() {}
+
+    virtual std::string                name() = 0;
+    virtual std::vector< WorkerState > workers() = 0;
+
+    virtual void add_thread() = 0;
+    virtual bool remove_thread() = 0;
+
+};
+
+/// Adapts an Active object to the IWatched interface
+template < typename AO >
+class Watched : public IWatched {
+
+public: // methods
+
+    Watched( const boost::shared_ptr<AO>& ao ) : ao_(ao) {}
+
+    virtual std::string                name()    { return ao_->name(); }
+    virtual std::vector< WorkerState > workers() { return ao_->workers(); }
+
+    virtual void add_thread()    { ao_->add_thread(); }
+    virtual bool remove_thread() { return ao_->remove_thread(); }
+
+private: // members
+
+    boost::shared_ptr<AO> ao_;
+
+};
+
+//-----------------------------------------------------------------------------
+
+/// Worker stuck in a message for longer than the threshold
+struct Stall
+{
+    Stall() : recovered(false), compensated(false) {}
+
+    std::string                          name;         ///< of the Active object
+    boost::thread::id                    worker;
+    boost::chrono::steady_clock::duration busy;        ///< time spent in the message so far
+    bool                                 recovered;    ///< the worker finished the message
+    bool                                 compensated;  ///< a replacement worker was added
+};
+
+inline std::ostream& operator<< ( std::ostream& s, const Stall& st )
+{
+    s << "Active [" << st.name << "] worker " << st.worker
+      << ( st.recovered ? " recovered after " : " stalled for " )
+      << boost::chrono::duration_cast< boost::chrono::milliseconds >( st.busy ).count() << " ms";
+    if( st.compensated )
+        s << ( st.recovered ? ", replacement removed" : ", replacement added" );
+    return s;
+}
+
+//-----------------------------------------------------------------------------
+
+/// Detects worker threads stuck in a message of the watched Active objects
+///
+/// Every period the watchdog looks at each worker's heartbeat: the time it started
+/// its current message. A worker busy for longer than the threshold is reported once
+/// as stalled, and reported again when it recovers. Optionally a replacement worker is
+/// added while it is stalled, so throughput holds, and removed once it recovers.
+
+class Watchdog : private boost::noncopyable {
+
+public: // types
+
+    typedef boost::chrono::steady_clock  clock_type;
+    typedef clock_type::duration         duration;
+
+    typedef boost::function< void ( const Stall& ) > report_type;
+
+protected: // types
+
+    struct Target
+    {
+        Target() : compensate(false) {}
+
+        IWatched::Ptr ao;
+        bool          compensate;   ///< add a worker while one is stalled
+    };
+
+    /// Stalls currently reported, per target and worker
+    typedef std::map< std::pair< size_t, boost::thread::id >, Stall > stalls_type;
+
+    typedef std::map< std::pair< size_t, boost::thread::id >, clock_type::time_point > since_type;
+
+protected: // data
+
+    mutable boost::mutex      m_;             ///< mutex for the targets and stalls
+
+    duration                  threshold_;     ///< service time above which a worker is stalled
+    duration                  period_;        ///< time between checks
+
+    report_type               report_;        ///< called on stalls and recoveries
+
+    std::vector< Target >     targets_;       ///< watched objects
+    stalls_type               stalls_;        ///< current stalls
+    since_type                since_;         ///< start of the stalled message
+    size_t                    detected_;      ///< nb stalls detected so far
+
+    boost::thread             thd_;           ///< watching thread, if started
+
+public: // methods
+
+    /// Constructor
+    /// @param threshold is the time in a single message after which a worker is stalled
+    /// @param report is called on stalls and recoveries, by default prints to std::cerr
+    Watchdog( duration threshold,
+              duration period = boost::chrono::milliseconds(100),
+              report_type report = report_type() ) :
+        threshold_(threshold),
+        period_(period),
+        report_(report),
+        detected_(0)
+    {
+        if( !report_ )
+            report_ = &Watchdog::print;
+    }
+
+    /// Destructor
+    /// Stops watching
+    ~Watchdog()
+    {
+        stop();
+    }
+
+    /// Watches an Active object
+    /// @param compensate adds a worker while one is stalled
+    template < typename AO >
+    void watch( const boost::shared_ptr<AO>& ao, bool compensate = false )
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+
+        Target t;
+        t.ao         = IWatched::Ptr( new Watched<AO>(ao) );
+        t.compensate = compensate;
+
+        targets_.push_back(t);
+    }
+
+    /// Starts watching periodically in a background thread
+    void start()
+    {
+        thd_ = boost::thread( &Watchdog::run, this );
+    }
+
+    /// Stops the background watching
+    void stop()
+    {
+        if( thd_.joinable() )
+        {
+            thd_.interrupt();
+            thd_.join();
+        }
+    }
+
+    /// Looks for stalled and recovered workers
+    void check()
+    {
+        std::vector< Stall > reports;
+        {
+            boost::lock_guard<boost::mutex> lock(m_);
+
+            clock_type::time_point now = clock_type::now();
+
+            for( size_t i = 0; i < targets_.size(); ++i )
+            {
+                Target& t = targets_[i];
+
+                std::vector< WorkerState > ws = t.ao->workers();
+
+                // recoveries: reported workers now idle or on another message
+
+                for( stalls_type::iterator s = stalls_.begin(); s != stalls_.end(); )
+                {
+                    if( s->first.first != i || busy_with( ws, s->first.second, since_[s->first] ) )
+                    {
+                        ++s;
+                        continue;
+                    }
+
+                    Stall r = s->second;
+                    r.recovered = true;
+                    r.busy      = now - since_[s->first];
+                    if( r.compensated )
+                        t.ao->remove_thread();
+                    reports.push_back(r);
+
+                    since_.erase( s->first );
+                    stalls_.erase( s++ );
+                }
+
+                // new stalls
+
+                for( size_t w = 0; w < ws.size(); ++w )
+                {
+                    if( ws[w].busy_since == clock_type::time_point() || now - ws[w].busy_since < threshold_ )
+                        continue;
+
+                    std::pair< size_t, boost::thread::id > key( i, ws[w].id );
+                    if( stalls_.count(key) )
+                        continue;
+
+                    Stall st;
+                    st.name   = t.ao->name();
+                    st.worker = ws[w].id;
+                    st.busy   = now - ws[w].busy_since;
+
+                    if( t.compensate )
+                    {
+                        t.ao->add_thread();
+                        st.compensated = true;
+                    }
+
+                    stalls_[key] = st;
+                    since_[key]  = ws[w].busy_since;
+                    ++detected_;
+
+                    reports.push_back(st);
+                }
+            }
+        }
+
+        for( size_t i = 0; i < reports.size(); ++i ) // report unlocked, may take time
+            report_( reports[i] );
+    }
+
+    /// @returns the nb of stalls detected so far
+    size_t detected() const
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        return detected_;
+    }
+
+    /// @returns the nb of workers stalled right now
+    size_t stalled() const
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        return stalls_.size();
+    }
+
+protected: // methods
+
+    /// @returns true if the worker is still busy with the message started at since
+    static bool busy_with( const std::vector< WorkerState >& ws, boost::thread::id id, clock_type::time_point since )
+    {
+        for( size_t w = 0; w < ws.size(); ++w )
+            if( ws[w].id == id )
+                return ws[w].busy_since == since;
+        return false; // worker is gone
+    }
+
+    static void print( const Stall& s )
+    {
+        std::ostringstream os;
+        os << "> watchdog: " << s << "\n";
+        std::cerr << os.str() << std::flush;
+    }
+
+    void run()
+    {
+        while( true )
+        {
+            try
+            {
+                boost::this_thread::sleep_for( period_ );
+                check();
+            }
+            catch ( boost::thread_interrupted& e )
+            {
+                break;
+            }
+        }
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
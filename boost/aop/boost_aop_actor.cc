@@ -0,0 +1,106 @@
+/**
+ * Active Objects using boost
+ *
+ * Lightweight actors sharing a small pool of worker threads
+ * One mailbox per session, no thread per session
+ *
+ **/
+
+#define BOOST_THREAD_VERSION 3
+
+#include <iostream>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/chrono.hpp>
+#include <boost/ref.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+
+#include "Actor.h"
+
+//-----------------------------------------------------------------------------
+
+#define HERE  std::cout << "--" << __LINE__ << std::endl;
+
+//-----------------------------------------------------------------------------
+
+#define N_ACTORS     1000000
+#define N_WORKERS          4
+#define N_PRODUCERS        4
+#define N_MESSAGES   1000000 // per producer
+#define BATCH_SIZE        64 // messages per activation
+
+//-----------------------------------------------------------------------------
+
+/// State of one session, only ever touched by its own actor
+struct Session
+{
+    Session() : count(0), sum(0) {}
+
+    void update( int v )
+    {
+        ++count;
+        sum += v;
+    }
+
+    size_t count;
+    long   sum;
+};
+
+typedef Actor<int> SessionActor;
+
+//-----------------------------------------------------------------------------
+
+void produce( std::vector< SessionActor::Ptr >* actors, unsigned int seed )
+{
+    boost::random::mt19937 gen(seed);
+    boost::random::uniform_int_distribution<size_t> dist(0, actors->size() - 1);
+
+    for( size_t i = 0; i < N_MESSAGES; ++i )
+        (*actors)[ dist(gen) ]->send( 1 );
+}
+
+//-----------------------------------------------------------------------------
+
+int main()
+{
+    std::cout << "> starting main" << std::endl;
+
+    Scheduler::Ptr sched = Scheduler::create( N_WORKERS, BATCH_SIZE );
+
+    std::vector< Session > sessions( N_ACTORS );
+    std::vector< SessionActor::Ptr > actors;
+    actors.reserve( N_ACTORS );
+
+    for( size_t i = 0; i < N_ACTORS; ++i )
+        actors.push_back( SessionActor::create( sched, boost::bind( &Session::update, boost::ref(sessions[i]), _1 ) ) );
+
+    std::cout << "> created " << actors.size() << " actors on " << sched->tsize() << " threads" << std::endl;
+
+    boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now();
+
+    std::vector< Scheduler::thread_ptr > prod;
+    for( size_t i = 0; i < N_PRODUCERS; ++i )
+        prod.push_back( Scheduler::thread_ptr( new boost::thread( produce, &actors, (unsigned int) i ) ) );
+
+    for( size_t i = 0; i < prod.size(); ++i )
+        prod[i]->join();
+
+    sched->drain();
+
+    boost::chrono::duration<double> elapsed = boost::chrono::steady_clock::now() - start;
+
+    size_t total = 0;
+    for( size_t i = 0; i < sessions.size(); ++i )
+        total += sessions[i].count;
+
+    std::cout << "> processed " << total << " messages in " << elapsed.count() << " s"
+              << " ( " << total / elapsed.count() << " msg/s )" << std::endl;
+
+    assert( total == N_PRODUCERS * N_MESSAGES );
+
+    actors.clear();
+
+    std::cout << "> ending main" << std::endl;
+}
@@ -0,0 +1,126 @@
+/**
+ * Active Objects using boost
+ *
+ * Admission control on overload
+ * Compares blocking sends against rejecting, dropping and rate limiting policies
+ *
+ **/
+
+#define BOOST_THREAD_VERSION 3
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/chrono.hpp>
+
+#include "Active.h"
+
+//-----------------------------------------------------------------------------
+
+#define HERE  std::cout << "--" << __LINE__ << std::endl;
+
+//-----------------------------------------------------------------------------
+
+#define RUN_TIME        1000 // ms per policy
+#define N_WORKERS          2
+#define QUEUE_SIZE       256
+
+#define DELAY_WORK         2 // ms  => capacity ~ 1000 msg/s
+#define DELAY_PRODUCER   200 // us  => offered  ~ 5000 msg/s
+
+//-----------------------------------------------------------------------------
+
+typedef boost::chrono::steady_clock clock_type;
+typedef boost::int64_t              stamp_type; ///< ns since clock epoch, time the message was sent
+
+boost::mutex               latency_mutex;
+std::vector< double >      latencies; // ms
+
+void work( stamp_type sent )
+{
+    boost::this_thread::sleep_for( boost::chrono::milliseconds(DELAY_WORK) );
+
+    stamp_type now = clock_type::now().time_since_epoch().count();
+
+    boost::lock_guard<boost::mutex> lock(latency_mutex);
+    latencies.push_back( ( now - sent ) / 1e6 );
+}
+
+//-----------------------------------------------------------------------------
+
+typedef Active<stamp_type,void> Worker;
+
+void run( const std::string& name, bool blocking, const admission_policy& policy )
+{
+    latencies.clear();
+
+    Worker::Ptr ao = Worker::create( &work, N_WORKERS, QUEUE_SIZE );
+    ao->admission( policy );
+
+    clock_type::time_point end = clock_type::now() + boost::chrono::milliseconds(RUN_TIME);
+
+    size_t offered = 0;
+    while( clock_type::now() < end )
+    {
+        stamp_type now = clock_type::now().time_since_epoch().count();
+
+        if( blocking )
+            ao->send( now );
+        else
+            ao->try_send( now );
+
+        ++offered;
+        boost::this_thread::sleep_for( boost::chrono::microseconds(DELAY_PRODUCER) );
+    }
+
+    ActiveStats st = ao->stats();
+
+    ao.reset(); // drains
+
+    std::sort( latencies.begin(), latencies.end() );
+
+    double p50 = latencies.empty() ? 0 : latencies[ latencies.size() / 2 ];
+    double p99 = latencies.empty() ? 0 : latencies[ latencies.size() * 99 / 100 ];
+
+    std::cout << std::setw(14) << name
+              << " offered "   << std::setw(5) << offered
+              << " processed " << std::setw(5) << latencies.size()
+              << " dropped "   << std::setw(5) << st.dropped
+              << " p50 "       << std::setw(7) << p50 << " ms"
+              << " p99 "       << std::setw(7) << p99 << " ms" << std::endl;
+}
+
+//-----------------------------------------------------------------------------
+
+int main()
+{
+    std::cout << "> starting main" << std::endl;
+
+    std::cout << std::fixed << std::setprecision(1);
+
+    admission_policy block;
+    run( "block", true, block );
+
+    admission_policy newest;
+    newest.overflow = admission_policy::REJECT_NEWEST;
+    run( "reject newest", false, newest );
+
+    admission_policy oldest;
+    oldest.overflow = admission_policy::DROP_OLDEST;
+    run( "drop oldest", false, oldest );
+
+    admission_policy bucket;
+    bucket.rate  = 900; // just below capacity
+    bucket.burst = 50;
+    run( "token bucket", false, bucket );
+
+    admission_policy early;
+    early.early_drop_min = boost::chrono::milliseconds(10);
+    early.early_drop_max = boost::chrono::milliseconds(50);
+    run( "early drop", false, early );
+
+    std::cout << "> ending main" << std::endl;
+}
@@ -0,0 +1,101 @@
+/**
+ * Active Objects using boost
+ *
+ * Active objects driven by an asio io_service
+ * Timer completions and messages share the same threads
+ *
+ **/
+
+#define BOOST_THREAD_VERSION 3
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include "ActiveAsio.h"
+
+//-----------------------------------------------------------------------------
+
+#define HERE  std::cout << "--" << __LINE__ << std::endl;
+
+//-----------------------------------------------------------------------------
+
+#define N_THREADS    4
+#define N_TIMERS    10
+#define N_MESSAGES 100
+
+//-----------------------------------------------------------------------------
+
+typedef AsioActive<int,std::string>  IntToStr;
+typedef AsioActive<std::string,void> Printer;
+
+std::string to_str( int i )
+{
+    std::ostringstream oss;
+    oss << i << " @ " << boost::this_thread::get_id();
+    return oss.str();
+}
+
+void print( std::string s )
+{
+    std::cout << s << std::endl;
+}
+
+/// Completion handler, hands over directly to the Active object on the same thread
+void expired( IntToStr::Ptr ao, int i, const boost::system::error_code& e )
+{
+    if( !e )
+        ao->send( 1000 + i );
+}
+
+//-----------------------------------------------------------------------------
+
+int main()
+{
+    std::cout << "> starting main" << std::endl;
+
+    boost::asio::io_service io;
+
+    {
+        AsioThreads threads( io, N_THREADS );
+
+        Printer::Ptr  printer = Printer::create( io, &print );
+        IntToStr::Ptr toStr   = IntToStr::create( io, &to_str, false ); // no shared state, run concurrently
+
+        toStr->pipe( printer );
+
+        // timer completions feed the active object
+
+        std::vector< boost::shared_ptr<boost::asio::deadline_timer> > timers;
+        for( int i = 0; i < N_TIMERS; ++i )
+        {
+            boost::shared_ptr<boost::asio::deadline_timer> t( new boost::asio::deadline_timer( io, boost::posix_time::milliseconds( 10 * i ) ) );
+            t->async_wait( boost::bind( &expired, toStr, i, boost::asio::placeholders::error ) );
+            timers.push_back(t);
+        }
+
+        // plain messages
+
+        for( int i = 0; i < N_MESSAGES; ++i )
+            toStr->send( i );
+
+        // messages with results
+
+        IntToStr::promise_ptr p ( new IntToStr::promise_type() );
+        toStr->send( 42, p );
+
+        std::cout << "> result [" << p->get_future().get() << "]" << std::endl;
+
+        boost::this_thread::sleep_for( boost::chrono::milliseconds( 20 * N_TIMERS ) );
+
+        // released in any order, the posted messages keep each object alive
+
+        toStr.reset();
+        printer.reset();
+    }
+
+    std::cout << "> ending main" << std::endl;
+}
@@ -0,0 +1,109 @@
+/**
+ * Active Objects using boost
+ *
+ * Memoized results of an expensive pure function
+ * Cache hits complete the promise without entering the queue
+ *
+ **/
+
+#define BOOST_THREAD_VERSION 3
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include <boost/chrono.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+
+#include "Active.h"
+
+//-----------------------------------------------------------------------------
+
+#define HERE  std::cout << "--" << __LINE__ << std::endl;
+
+//-----------------------------------------------------------------------------
+
+#define N_REQUESTS     20000
+#define N_ROUNDS          40 // requests are sent in rounds, waiting for each round
+#define N_KEYS          5000
+#define N_WORKERS          4
+#define CACHE_ENTRIES    512
+#define CACHE_TTL       1000 // ms
+
+#define DELAY_WORK       200 // us
+
+//-----------------------------------------------------------------------------
+
+/// Expensive and pure
+double slow_sqrt( int i )
+{
+    boost::this_thread::sleep_for( boost::chrono::microseconds(DELAY_WORK) );
+    return std::sqrt( double(i) );
+}
+
+typedef Active<int,double>        Sqrt;
+typedef ResultCache<int,double>   SqrtCache;
+
+//-----------------------------------------------------------------------------
+
+/// Skewed requests, few keys are very hot
+std::vector<int> requests()
+{
+    boost::random::mt19937 gen;
+    boost::random::uniform_real_distribution<> dist(0,1);
+
+    std::vector<int> r;
+    for( int i = 0; i < N_REQUESTS; ++i )
+        r.push_back( int( N_KEYS * std::pow( dist(gen), 4. ) ) );
+    return r;
+}
+
+void run( const std::string& name, SqrtCache::Ptr cache )
+{
+    Sqrt::Ptr ao = Sqrt::create( &slow_sqrt, N_WORKERS );
+    ao->cache( cache );
+
+    std::vector<int> reqs = requests();
+
+    boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now();
+
+    double sum = 0;
+    for( size_t r = 0; r < N_ROUNDS; ++r )
+    {
+        std::vector< Sqrt::promise_ptr > promises;
+
+        for( size_t i = r; i < reqs.size(); i += N_ROUNDS )
+        {
+            Sqrt::promise_ptr p( new Sqrt::promise_type() );
+            ao->send( reqs[i], p );
+            promises.push_back(p);
+        }
+
+        for( size_t i = 0; i < promises.size(); ++i )
+            sum += promises[i]->get_future().get();
+    }
+
+    boost::chrono::duration<double> elapsed = boost::chrono::steady_clock::now() - start;
+
+    ActiveStats st = ao->stats();
+
+    std::cout << "> " << name
+              << " sum "       << sum
+              << " executed "  << st.processed
+              << " hits "      << st.cache_hits
+              << " misses "    << st.cache_misses
+              << " in "        << elapsed.count() << " s" << std::endl;
+}
+
+//-----------------------------------------------------------------------------
+
+int main()
+{
+    std::cout << "> starting main" << std::endl;
+
+    run( "no cache  ", SqrtCache::Ptr() );
+    run( "with cache", SqrtCache::create( CACHE_ENTRIES, 0, boost::chrono::milliseconds(CACHE_TTL) ) );
+
+    std::cout << "> ending main" << std::endl;
+}
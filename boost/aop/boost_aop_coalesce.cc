@@ -0,0 +1,115 @@
+/**
+ * Active Objects using boost
+ *
+ * Coalescing mailbox, only the latest update per key is processed
+ * Work stays bounded by the nb of keys while producers burst
+ *
+ **/
+
+#define BOOST_THREAD_VERSION 3
+
+#include <iostream>
+#include <vector>
+
+#include <boost/chrono.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+
+#include "ActiveCoalescing.h"
+
+//-----------------------------------------------------------------------------
+
+#define HERE  std::cout << "--" << __LINE__ << std::endl;
+
+//-----------------------------------------------------------------------------
+
+#define N_KEYS        1000
+#define N_UPDATES  1000000
+#define N_WORKERS        2
+
+#define DELAY_WORK      20 // us
+
+//-----------------------------------------------------------------------------
+
+/// State update, only the newest value per key matters
+struct Quote
+{
+    Quote() : key(0), seq(0) {}
+    Quote( size_t k, size_t s ) : key(k), seq(s) {}
+
+    size_t key;
+    size_t seq;   ///< increases with each update of a key
+};
+
+size_t quote_key( const Quote& q ) { return q.key; }
+
+boost::mutex          book_mutex;
+std::vector< size_t > book( N_KEYS, 0 ); ///< latest seq applied per key
+size_t                processed = 0;
+
+size_t apply( Quote q )
+{
+    boost::this_thread::sleep_for( boost::chrono::microseconds(DELAY_WORK) );
+
+    boost::lock_guard<boost::mutex> lock(book_mutex);
+    if( q.seq > book[q.key] )
+        book[q.key] = q.seq;
+    ++processed;
+    return q.seq;
+}
+
+//-----------------------------------------------------------------------------
+
+int main()
+{
+    std::cout << "> starting main" << std::endl;
+
+    typedef CoalescingActive<Quote,size_t,size_t> Book;
+
+    Book::Ptr ao = Book::create( &apply, &quote_key, N_WORKERS );
+
+    boost::random::mt19937 gen;
+    boost::random::uniform_int_distribution<size_t> dist(0, N_KEYS - 1);
+
+    std::vector< size_t > latest( N_KEYS, 0 );
+
+    boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now();
+
+    for( size_t i = 1; i <= N_UPDATES; ++i )
+    {
+        size_t k = dist(gen);
+        latest[k] = i;
+        ao->send( Quote(k,i) );
+    }
+
+    // the promise completes with the latest update of its key
+
+    Book::promise_ptr p( new Book::promise_type() );
+    ao->send( Quote(0, N_UPDATES + 1), p );
+    latest[0] = N_UPDATES + 1;
+
+    std::cout << "> key 0 is at seq " << p->get_future().get() << std::endl;
+
+    size_t coalesced = ao->coalesced();
+
+    ao.reset(); // drains
+
+    boost::chrono::duration<double> elapsed = boost::chrono::steady_clock::now() - start;
+
+    size_t stale = 0;
+    for( size_t k = 0; k < N_KEYS; ++k )
+        if( book[k] != latest[k] )
+            ++stale;
+
+    std::cout << "> sent "      << N_UPDATES + 1
+              << " processed "  << processed
+              << " coalesced "  << coalesced
+              << " in "         << elapsed.count() << " s" << std::endl;
+
+    std::cout << "> keys with stale state " << stale << std::endl;
+
+    assert( stale == 0 );
+    assert( processed + coalesced == N_UPDATES + 1 );
+
+    std::cout << "> ending main" << std::endl;
+}
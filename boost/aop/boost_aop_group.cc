@@ -0,0 +1,106 @@
+/**
+ * Active Objects using boost
+ *
+ * Group of replicated Active objects behind one front-end
+ * Compares routing by random choice, two choices and least outstanding work
+ *
+ **/
+
+#define BOOST_THREAD_VERSION 3
+
+#include <iostream>
+#include <vector>
+
+#include <boost/chrono.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/exponential_distribution.hpp>
+
+#include "ActiveGroup.h"
+
+//-----------------------------------------------------------------------------
+
+#define HERE  std::cout << "--" << __LINE__ << std::endl;
+
+//-----------------------------------------------------------------------------
+
+#define N_JOBS        20000
+#define N_MEMBERS         4
+#define MEAN_WORK        40 // us
+#define SEND_PERIOD      12 // us, a bit above the group capacity
+
+//-----------------------------------------------------------------------------
+
+/// Job of variable cost
+size_t work( size_t us )
+{
+    boost::this_thread::sleep_for( boost::chrono::microseconds(us) );
+    return us;
+}
+
+typedef ActiveGroup<size_t,size_t> Group;
+
+size_t by_key( const size_t& us ) { return us; }
+
+//-----------------------------------------------------------------------------
+
+void run( const std::string& name, Group::routing r, Group::key_function_type k = Group::key_function_type() )
+{
+    Group::Ptr g = Group::create( &work, N_MEMBERS, 1, 0, r, k );
+
+    boost::random::mt19937 gen;
+    boost::random::exponential_distribution<> cost( 1. / MEAN_WORK );
+
+    boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now();
+    boost::chrono::steady_clock::time_point next  = start;
+
+    size_t max_spread = 0;
+
+    for( size_t i = 0; i < N_JOBS; ++i )
+    {
+        g->send( size_t( cost(gen) ) );
+
+        next += boost::chrono::microseconds(SEND_PERIOD);
+        boost::this_thread::sleep_until( next );
+
+        if( i % 100 == 0 ) // sample how uneven the queues are
+        {
+            size_t lo = g->member(0)->qsize(), hi = lo;
+            for( size_t m = 1; m < g->size(); ++m )
+            {
+                size_t q = g->member(m)->qsize();
+                lo = std::min(lo,q);
+                hi = std::max(hi,q);
+            }
+            max_spread = std::max( max_spread, hi - lo );
+        }
+    }
+
+    std::vector<size_t> processed;
+    for( size_t m = 0; m < g->size(); ++m )
+        processed.push_back( g->member(m)->stats().processed );
+
+    g.reset(); // drains
+
+    boost::chrono::duration<double> elapsed = boost::chrono::steady_clock::now() - start;
+
+    std::cout << "> " << name
+              << " max queue spread " << max_spread
+              << " in " << elapsed.count() << " s, processed";
+    for( size_t m = 0; m < processed.size(); ++m )
+        std::cout << " " << processed[m];
+    std::cout << std::endl;
+}
+
+//-----------------------------------------------------------------------------
+
+int main()
+{
+    std::cout << "> starting main" << std::endl;
+
+    run( "random           ", Group::RANDOM );
+    run( "two choices      ", Group::TWO_CHOICES );
+    run( "least outstanding", Group::LEAST_OUTSTANDING );
+    run( "key affinity     ", Group::TWO_CHOICES, &by_key );
+
+    std::cout << "> ending main" << std::endl;
+}
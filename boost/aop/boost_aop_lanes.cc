@@ -0,0 +1,143 @@
+/**
+ * Active Objects using boost
+ *
+ * Lanes separating interactive requests from bulk jobs
+ * Interactive latency with a saturating bulk backlog, in one FIFO versus lanes
+ *
+ **/
+
+#define BOOST_THREAD_VERSION 3
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include <boost/chrono.hpp>
+
+#include "ActiveLanes.h"
+
+//-----------------------------------------------------------------------------
+
+#define HERE  std::cout << "--" << __LINE__ << std::endl;
+
+//-----------------------------------------------------------------------------
+
+#define N_WORKERS          4
+#define N_INTERACTIVE    100
+#define INTERACTIVE_WORK  50 // us
+#define INTERACTIVE_EVERY  2 // ms
+#define BULK_WORK        500 // us
+#define BULK_QUEUE       400
+
+//-----------------------------------------------------------------------------
+
+typedef boost::chrono::steady_clock clock_type;
+
+/// Job taking some microseconds, returns when it finished
+clock_type::time_point work( int us )
+{
+    boost::this_thread::sleep_for( boost::chrono::microseconds(us) );
+    return clock_type::now();
+}
+
+typedef Active<int,clock_type::time_point>      Fifo;
+typedef LanedActive<int,clock_type::time_point> Laned;
+
+//-----------------------------------------------------------------------------
+
+/// Keeps the bulk queue full until stopped
+template < typename Send >
+void bulk( Send send, bool& stop )
+{
+    while( !stop )
+        send();
+}
+
+void report( const std::string& name, std::vector<double>& lat )
+{
+    std::sort( lat.begin(), lat.end() );
+    std::cout << "> " << name
+              << " interactive p50 " << lat[ lat.size() / 2 ]          << " ms"
+              << " p99 "             << lat[ lat.size() * 99 / 100 ]   << " ms" << std::endl;
+}
+
+/// Sends interactive requests at a steady pace and measures their latency
+template < typename SendInteractive >
+std::vector<double> interactive( SendInteractive send )
+{
+    std::vector<double> lat;
+    for( int i = 0; i < N_INTERACTIVE; ++i )
+    {
+        Fifo::promise_ptr p( new Fifo::promise_type() );
+        clock_type::time_point start = clock_type::now();
+        send( p );
+        boost::chrono::duration<double,boost::milli> d = p->get_future().get() - start;
+        lat.push_back( d.count() );
+        boost::this_thread::sleep_for( boost::chrono::milliseconds(INTERACTIVE_EVERY) );
+    }
+    return lat;
+}
+
+//-----------------------------------------------------------------------------
+
+struct FifoBulk        { Fifo::Ptr ao;                 void operator()() { ao->send( BULK_WORK ); } };
+struct FifoInteractive { Fifo::Ptr ao;                 void operator()( Fifo::promise_ptr p ) { ao->send( INTERACTIVE_WORK, p ); } };
+struct LaneBulk        { Laned::Ptr ao; size_t lane;   void operator()() { ao->send( lane, BULK_WORK ); } };
+struct LaneInteractive { Laned::Ptr ao; size_t lane;   void operator()( Laned::promise_ptr p ) { ao->send( lane, INTERACTIVE_WORK, p ); } };
+
+void run_fifo()
+{
+    Fifo::Ptr ao = Fifo::create( &work, N_WORKERS, BULK_QUEUE );
+
+    bool stop = false;
+    FifoBulk b = { ao };
+    boost::thread producer( boost::bind( &bulk<FifoBulk>, b, boost::ref(stop) ) );
+
+    FifoInteractive i = { ao };
+    std::vector<double> lat = interactive( i );
+
+    stop = true;
+    producer.join();
+
+    report( "single fifo            ", lat );
+}
+
+void run_lanes( const std::string& name, Laned::service s, bool reserved )
+{
+    Laned::Ptr ao = Laned::create( &work, reserved ? N_WORKERS - 1 : N_WORKERS, s );
+
+    size_t critical = ao->add_lane( "interactive", 0, 4 );
+    size_t batch    = ao->add_lane( "bulk", BULK_QUEUE, 1 );
+
+    if( reserved )
+        ao->reserve( critical );
+
+    bool stop = false;
+    LaneBulk b = { ao, batch };
+    boost::thread producer( boost::bind( &bulk<LaneBulk>, b, boost::ref(stop) ) );
+
+    LaneInteractive i = { ao, critical };
+    std::vector<double> lat = interactive( i );
+
+    stop = true;
+    producer.join();
+
+    report( name, lat );
+
+    std::cout << ">   processed interactive " << ao->processed( critical )
+              << " bulk " << ao->processed( batch ) << std::endl;
+}
+
+//-----------------------------------------------------------------------------
+
+int main()
+{
+    std::cout << "> starting main" << std::endl;
+
+    run_fifo();
+    run_lanes( "weighted fair lanes    ", Laned::WEIGHTED_FAIR,   false );
+    run_lanes( "strict priority lanes  ", Laned::STRICT_PRIORITY, false );
+    run_lanes( "weighted fair, reserved", Laned::WEIGHTED_FAIR,   true );
+
+    std::cout << "> ending main" << std::endl;
+}
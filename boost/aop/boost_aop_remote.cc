@@ -0,0 +1,119 @@
+/**
+ * Active Objects using boost
+ *
+ * Pipeline spanning a socket, the stage code does not change
+ * Runs over a unix domain socket and over tcp on loopback
+ *
+ **/
+
+#define BOOST_THREAD_VERSION 3
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+#include <boost/chrono.hpp>
+
+#include "ActiveAsio.h"
+#include "RemoteActive.h"
+
+//-----------------------------------------------------------------------------
+
+#define HERE  std::cout << "--" << __LINE__ << std::endl;
+
+//-----------------------------------------------------------------------------
+
+#define N_MESSAGES  500000
+#define MAX_PENDING  10000
+#define SOCKET_PATH "/tmp/boost_aop_remote.sock"
+
+//-----------------------------------------------------------------------------
+
+typedef Active<int,double>   Sqrt;
+typedef Active<double,void>  Sum;
+
+double to_sqrt( int i ) { return std::sqrt( double(i) ); }
+
+double total = 0;
+
+void sum( double d ) { total += d; }
+
+//-----------------------------------------------------------------------------
+
+template < typename Protocol >
+void run( const std::string& name, const typename Protocol::endpoint& ep )
+{
+    typedef RemoteActive<double,Protocol> Proxy;
+    typedef RemoteServer<double,Protocol> Server;
+
+    boost::asio::io_service server_io;  // would be in another process or host
+    boost::asio::io_service client_io;
+
+    total = 0;
+
+    AsioThreads server_threads( server_io, 1 );
+    AsioThreads client_threads( client_io, 1 );
+
+    Sum::Ptr sink = Sum::create( &sum, 1, MAX_PENDING );
+
+    typename Server::Ptr server = Server::create( server_io, ep, sink );
+
+    boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now();
+
+    size_t writes = 0;
+    {
+        typename Proxy::Ptr proxy = Proxy::create( client_io, server->endpoint(), MAX_PENDING );
+
+        Sqrt::Ptr source = Sqrt::create( &to_sqrt );
+
+        source | proxy;
+
+        for( int i = 0; i < N_MESSAGES; ++i )
+            source->send( i );
+
+        source.reset(); // drains into the proxy
+        proxy->flush();
+        writes = proxy->writes();
+    }
+
+    while( server->received() < N_MESSAGES )
+        boost::this_thread::sleep_for( boost::chrono::milliseconds(1) );
+
+    // the server still holds the sink, so wait for it to process what it received
+
+    Sum::promise_ptr done( new Sum::promise_type() );
+    sink->send( 0., done );
+    done->get_future().get();
+
+    boost::chrono::duration<double> elapsed = boost::chrono::steady_clock::now() - start;
+
+    server->close();
+
+    double expected = 0;
+    for( int i = 0; i < N_MESSAGES; ++i )
+        expected += to_sqrt(i);
+
+    std::cout << "> " << name
+              << " " << N_MESSAGES << " messages in " << writes << " writes"
+              << " in " << elapsed.count() << " s"
+              << " (" << N_MESSAGES / elapsed.count() << " msg/s)"
+              << " sum " << ( total == expected ? "ok" : "WRONG" ) << std::endl;
+
+    assert( total == expected );
+}
+
+//-----------------------------------------------------------------------------
+
+int main()
+{
+    std::cout << "> starting main" << std::endl;
+
+    std::remove( SOCKET_PATH );
+    run< boost::asio::local::stream_protocol >( "unix socket", boost::asio::local::stream_protocol::endpoint( SOCKET_PATH ) );
+    std::remove( SOCKET_PATH );
+
+    // port 0 lets the system choose
+    run< boost::asio::ip::tcp >( "tcp loopback", boost::asio::ip::tcp::endpoint( boost::asio::ip::address_v4::loopback(), 0 ) );
+
+    std::cout << "> ending main" << std::endl;
+}
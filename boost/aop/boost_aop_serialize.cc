@@ -0,0 +1,205 @@
+/**
+ * Active Objects using boost
+ *
+ * Binary encoding of messages versus the stream based conversions
+ * Measures bytes/s and size of each encoding, round trip included
+ *
+ **/
+
+#include <cassert>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/chrono.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include "Serialize.h"
+
+//-----------------------------------------------------------------------------
+
+#define HERE  std::cout << "--" << __LINE__ << std::endl;
+
+//-----------------------------------------------------------------------------
+
+#define N_MESSAGES  1000000
+
+//-----------------------------------------------------------------------------
+
+/// Message with a bit of everything
+struct Order
+{
+    Order() : id(0), qty(0), price(0) {}
+
+    long        id;
+    int         qty;     ///< negative for sells
+    double      price;
+    std::string symbol;
+
+    bool operator== ( const Order& o ) const
+    {
+        return id == o.id && qty == o.qty && price == o.price && symbol == o.symbol;
+    }
+};
+
+template <>
+struct binary_traits< Order >
+{
+    static void write( BinaryWriter& w, const Order& o )
+    {
+        binary_traits<long>::write( w, o.id );
+        binary_traits<int>::write( w, o.qty );
+        binary_traits<double>::write( w, o.price );
+        binary_traits<std::string>::write( w, o.symbol );
+    }
+
+    static void read( BinaryReader& r, Order& o )
+    {
+        binary_traits<long>::read( r, o.id );
+        binary_traits<int>::read( r, o.qty );
+        binary_traits<double>::read( r, o.price );
+        binary_traits<std::string>::read( r, o.symbol );
+    }
+};
+
+std::ostream& operator<< ( std::ostream& s, const Order& o )
+{
+    s.precision(17);
+    return s << o.id << ' ' << o.qty << ' ' << o.price << ' ' << o.symbol;
+}
+
+std::istream& operator>> ( std::istream& s, Order& o )
+{
+    return s >> o.id >> o.qty >> o.price >> o.symbol;
+}
+
+//-----------------------------------------------------------------------------
+
+/// Encodings, each appends to a buffer and reads back from a frame
+
+struct Binary
+{
+    template < typename T >
+    static void encode( const T& v, std::string& out ) { binary_encode( v, out ); }
+
+    template < typename T >
+    static T decode( const char* p, size_t n ) { return binary_decode<T>( p, n ); }
+};
+
+struct Stream
+{
+    template < typename T >
+    static void encode( const T& v, std::string& out )
+    {
+        std::ostringstream s;
+        s.precision(17);
+        s << v;
+        out += s.str();
+    }
+
+    template < typename T >
+    static T decode( const char* p, size_t n )
+    {
+        std::istringstream s( std::string(p,n) );
+        T v;
+        s >> v;
+        return v;
+    }
+};
+
+struct LexicalCast
+{
+    template < typename T >
+    static void encode( const T& v, std::string& out ) { out += boost::lexical_cast<std::string>( v ); }
+
+    template < typename T >
+    static T decode( const char* p, size_t n ) { return boost::lexical_cast<T>( p, n ); }
+};
+
+//-----------------------------------------------------------------------------
+
+template < typename Encoding, typename T >
+void bench( const std::string& name, const std::vector<T>& msgs )
+{
+    typedef boost::chrono::steady_clock clock;
+
+    std::string buf;
+    std::vector<size_t> ends;   // frame boundaries
+    ends.reserve( msgs.size() );
+
+    clock::time_point start = clock::now();
+
+    for( size_t i = 0; i < msgs.size(); ++i )
+    {
+        Encoding::encode( msgs[i], buf );
+        ends.push_back( buf.size() );
+    }
+
+    clock::time_point mid = clock::now();
+
+    size_t bad = 0;
+    size_t b = 0;
+    for( size_t i = 0; i < msgs.size(); ++i )
+    {
+        if( !( Encoding::template decode<T>( buf.data() + b, ends[i] - b ) == msgs[i] ) )
+            ++bad;
+        b = ends[i];
+    }
+
+    clock::time_point end = clock::now();
+
+    boost::chrono::duration<double> enc = mid - start;
+    boost::chrono::duration<double> dec = end - mid;
+
+    std::cout << "> " << name
+              << " " << double( buf.size() ) / msgs.size() << " bytes/msg"
+              << ", encode " << buf.size() / enc.count() / 1e6 << " MB/s " << msgs.size() / enc.count() / 1e6 << " Mmsg/s"
+              << ", decode " << buf.size() / dec.count() / 1e6 << " MB/s " << msgs.size() / dec.count() / 1e6 << " Mmsg/s"
+              << ( bad ? ", ROUND TRIP FAILED" : "" ) << std::endl;
+
+    assert( !bad );
+}
+
+template < typename T >
+void bench_all( const std::string& what, const std::vector<T>& msgs )
+{
+    std::cout << "> " << what << std::endl;
+    bench<Binary>       ( "  binary      ", msgs );
+    bench<Stream>       ( "  ostringstream", msgs );
+    bench<LexicalCast>  ( "  lexical_cast", msgs );
+}
+
+//-----------------------------------------------------------------------------
+
+int main()
+{
+    std::cout << "> starting main" << std::endl;
+
+    std::vector<int>    ints;
+    std::vector<double> dbls;
+    std::vector<Order>  orders;
+
+    for( int i = 0; i < N_MESSAGES; ++i )
+    {
+        ints.push_back( ( i % 2 ? -1 : 1 ) * ( i % 1000 ) );
+        dbls.push_back( i / 7. );
+
+        Order o;
+        o.id     = 1000000 + i;
+        o.qty    = ( i % 2 ? -1 : 1 ) * ( i % 500 );
+        o.price  = 100 + i / 100.;
+        o.symbol = i % 3 ? "ABCD" : "XYZ";
+        orders.push_back(o);
+    }
+
+    bench_all( "int",    ints );
+    bench_all( "double", dbls );
+
+    // lexical_cast does not split on spaces, so only stream for structured messages
+    std::cout << "> Order" << std::endl;
+    bench<Binary>( "  binary      ", orders );
+    bench<Stream>( "  ostringstream", orders );
+
+    std::cout << "> ending main" << std::endl;
+}
@@ -0,0 +1,111 @@
+/**
+ * Active Objects using boost
+ *
+ * Single flight of identical requests
+ * Concurrent callers asking for the same key share one execution
+ *
+ **/
+
+#define BOOST_THREAD_VERSION 3
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include <boost/chrono.hpp>
+#include <boost/thread/barrier.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+
+#include "Active.h"
+
+//-----------------------------------------------------------------------------
+
+#define HERE  std::cout << "--" << __LINE__ << std::endl;
+
+//-----------------------------------------------------------------------------
+
+#define N_CLIENTS         16
+#define N_REQUESTS       500 // per client
+#define N_KEYS            20
+#define N_WORKERS          4
+
+#define DELAY_WORK       500 // us
+
+//-----------------------------------------------------------------------------
+
+/// Expensive and pure
+double slow_sqrt( int i )
+{
+    boost::this_thread::sleep_for( boost::chrono::microseconds(DELAY_WORK) );
+    return std::sqrt( double(i) );
+}
+
+typedef Active<int,double> Sqrt;
+
+//-----------------------------------------------------------------------------
+
+/// Client asking for few hot keys, waiting for each answer
+void client( Sqrt::Ptr ao, boost::barrier& go, size_t seed, double& sum )
+{
+    boost::random::mt19937 gen(seed);
+    boost::random::uniform_int_distribution<int> dist(0, N_KEYS - 1);
+
+    go.wait();
+
+    for( size_t i = 0; i < N_REQUESTS; ++i )
+    {
+        Sqrt::promise_ptr p( new Sqrt::promise_type() );
+        ao->send( dist(gen), p );
+        sum += p->get_future().get();
+    }
+}
+
+void run( const std::string& name, bool single_flight )
+{
+    Sqrt::Ptr ao = Sqrt::create( &slow_sqrt, N_WORKERS );
+    ao->single_flight( single_flight );
+
+    boost::barrier go( N_CLIENTS + 1 );
+
+    std::vector<double> sums( N_CLIENTS, 0 );
+    boost::thread_group clients;
+    for( size_t c = 0; c < N_CLIENTS; ++c )
+        clients.create_thread( boost::bind( &client, ao, boost::ref(go), c, boost::ref(sums[c]) ) );
+
+    go.wait();
+    boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now();
+
+    clients.join_all();
+
+    boost::chrono::duration<double> elapsed = boost::chrono::steady_clock::now() - start;
+
+    double sum = 0;
+    for( size_t c = 0; c < N_CLIENTS; ++c )
+        sum += sums[c];
+
+    while( ao->outstanding() ) // promises are set before the workers count the message
+        boost::this_thread::yield();
+
+    ActiveStats st = ao->stats();
+
+    std::cout << "> " << name
+              << " sum "       << sum
+              << " executed "  << st.processed
+              << " shared "    << st.shared
+              << " in "        << elapsed.count() << " s" << std::endl;
+
+    assert( st.processed + st.shared == N_CLIENTS * N_REQUESTS );
+}
+
+//-----------------------------------------------------------------------------
+
+int main()
+{
+    std::cout << "> starting main" << std::endl;
+
+    run( "every request  ", false );
+    run( "single flight  ", true );
+
+    std::cout << "> ending main" << std::endl;
+}
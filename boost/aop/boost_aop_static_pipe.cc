@@ -0,0 +1,125 @@
+/**
+ * Active Objects using boost
+ *
+ * Statically typed pipeline versus the type erased one
+ * Same stages, same queues, no virtual calls nor shared_ptr copies between stages
+ *
+ **/
+
+#define BOOST_THREAD_VERSION 3
+
+#include <iostream>
+
+#include <boost/chrono.hpp>
+
+#include "StaticPipe.h"
+
+//-----------------------------------------------------------------------------
+
+#define HERE  std::cout << "--" << __LINE__ << std::endl;
+
+//-----------------------------------------------------------------------------
+
+#define N_MESSAGES  2000000
+#define QUEUE_SIZE     1000
+
+//-----------------------------------------------------------------------------
+
+struct Inc  { int    operator() ( int i )    const { return i + 1; } };
+struct Half { double operator() ( int i )    const { return i / 2.; } };
+
+double total = 0;
+
+struct Sum  { void   operator() ( double d ) const { total += d; } };
+
+struct Twice { int operator() ( int i ) const { return 2 * i; } };
+
+size_t printed = 0;
+
+void count( int ) { ++printed; }
+
+//-----------------------------------------------------------------------------
+
+typedef boost::chrono::steady_clock clock_type;
+
+void report( const std::string& name, clock_type::time_point start )
+{
+    boost::chrono::duration<double> elapsed = clock_type::now() - start;
+    std::cout << "> " << name
+              << " " << N_MESSAGES / elapsed.count() << " msg/s"
+              << " sum " << total << std::endl;
+}
+
+void dynamic_pipe()
+{
+    total = 0;
+
+    Active<int,int>::Ptr     inc  = Active<int,int>::create( Inc(), 1, QUEUE_SIZE );
+    Active<int,double>::Ptr  half = Active<int,double>::create( Half(), 1, QUEUE_SIZE );
+    Active<double,void>::Ptr sum  = Active<double,void>::create( Sum(), 1, QUEUE_SIZE );
+
+    inc | half | sum;
+
+    clock_type::time_point start = clock_type::now();
+
+    for( int i = 0; i < N_MESSAGES; ++i )
+        inc->send( i );
+
+    inc.reset(); // drains front to back
+    half.reset();
+    sum.reset();
+
+    report( "type erased pipe", start );
+}
+
+template < typename Spec >
+void static_pipe( const Spec& spec )
+{
+    total = 0;
+
+    boost::shared_ptr< typename static_pipe_of<Spec>::type > p = make_static_pipe( spec );
+
+    clock_type::time_point start = clock_type::now();
+
+    for( int i = 0; i < N_MESSAGES; ++i )
+        p->send( i );
+
+    p.reset(); // drains front to back
+
+    report( "static pipe     ", start );
+}
+
+//-----------------------------------------------------------------------------
+
+int main()
+{
+    std::cout << "> starting main" << std::endl;
+
+    dynamic_pipe();
+
+    static_pipe( stage<int,int>   ( Inc(),  1, QUEUE_SIZE ) |
+                 stage<int,double>( Half(), 1, QUEUE_SIZE ) |
+                 stage<double,void>( Sum(), 1, QUEUE_SIZE ) );
+
+    // at the edges the runtime sees plain IActive objects
+
+    {
+        Active<int,void>::Ptr printer = Active<int,void>::create( &count );
+
+        typedef ChainSpec< StageSpec<int,int,Twice>, ExitSpec<int> > Spec;
+
+        Spec spec = stage<int,int>( Twice() ) | exit_to<int>( printer );
+
+        IActive<int>::Ptr entry = StaticEntry< static_pipe_of<Spec>::type >::create( make_static_pipe( spec ) );
+
+        for( int i = 0; i < 10; ++i )
+            entry->send( i );
+
+        entry.reset();
+        printer.reset();
+
+        std::cout << "> edges passed " << printed << " messages" << std::endl;
+    }
+
+    std::cout << "> ending main" << std::endl;
+}
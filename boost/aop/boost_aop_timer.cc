@@ -0,0 +1,109 @@
+/**
+ * Active Objects using boost
+ *
+ * Delayed messages through a hierarchical timer wheel
+ * No thread sleeps while messages are pending
+ *
+ **/
+
+#define BOOST_THREAD_VERSION 3
+
+#include <iostream>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/chrono.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+
+#include "Active.h"
+
+//-----------------------------------------------------------------------------
+
+#define HERE  std::cout << "--" << __LINE__ << std::endl;
+
+//-----------------------------------------------------------------------------
+
+#define N_TIMERS     1000000
+#define MAX_DELAY       2000 // ms
+
+//-----------------------------------------------------------------------------
+
+boost::mutex count_mutex;
+size_t       count = 0;
+
+void tick( int )
+{
+    boost::lock_guard<boost::mutex> lock(count_mutex);
+    ++count;
+}
+
+void print( std::string s )
+{
+    std::cout << s << std::endl;
+}
+
+//-----------------------------------------------------------------------------
+
+int main()
+{
+    std::cout << "> starting main" << std::endl;
+
+    typedef boost::chrono::steady_clock clock;
+    typedef Active<int,void>          Ticker;
+    typedef Active<std::string,void>  Printer;
+
+    Printer::Ptr printer = Printer::create( &print );
+
+    printer->send_after( boost::chrono::milliseconds(300), "[3] after 300 ms" );
+    printer->send_after( boost::chrono::milliseconds(100), "[1] after 100 ms" );
+    printer->send_at( clock::now() + boost::chrono::milliseconds(200), "[2] at now + 200 ms" );
+
+    TimerWheel::TimerId never = printer->send_after( boost::chrono::milliseconds(150), "!! cancelled message was sent" );
+    printer->cancel( never );
+
+    // schedule lots of timers, cancel half of them
+
+    Ticker::Ptr ticker = Ticker::create( &tick );
+
+    boost::random::mt19937 gen;
+    boost::random::uniform_int_distribution<> dist(1,MAX_DELAY);
+
+    std::vector< TimerWheel::TimerId > ids;
+    ids.reserve( N_TIMERS );
+
+    clock::time_point start = clock::now();
+
+    for( int i = 0; i < N_TIMERS; ++i )
+        ids.push_back( ticker->send_after( boost::chrono::milliseconds( dist(gen) ), i ) );
+
+    boost::chrono::duration<double> scheduled = clock::now() - start;
+
+    start = clock::now();
+
+    size_t cancelled = 0;
+    for( size_t i = 0; i < ids.size(); i += 2 )
+        if( ticker->cancel( ids[i] ) )
+            ++cancelled;
+
+    boost::chrono::duration<double> cancelling = clock::now() - start;
+
+    std::cout << "> scheduled " << ids.size() << " timers in " << scheduled.count() << " s, "
+              << "cancelled " << cancelled << " in " << cancelling.count() << " s" << std::endl;
+
+    // timers only hold weak references, so keep the ticker until all were enqueued
+
+    while( ticker->timers()->size() || ticker->admission().admitted < ids.size() - cancelled )
+        boost::this_thread::sleep_for( boost::chrono::milliseconds(100) );
+
+    ticker.reset(); // drains queue
+
+    std::cout << "> delivered " << count << " messages, expected " << ids.size() - cancelled
+              << ", failed timer callbacks " << TimerWheel::instance()->failed() << std::endl;
+
+    assert( count == ids.size() - cancelled );
+
+    printer.reset();
+
+    std::cout << "> ending main" << std::endl;
+}
@@ -0,0 +1,122 @@
+/**
+ * Active Objects using boost
+ *
+ * Pipe of Active objects with threads reassigned to the bottleneck at runtime
+ * Every stage starts with one thread, the tuner distributes the rest of the budget
+ *
+ **/
+
+#define BOOST_THREAD_VERSION 3
+
+#include <iostream>
+#include <sstream>
+
+#include <boost/chrono.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include "PipeTuner.h"
+
+//-----------------------------------------------------------------------------
+
+#define HERE  std::cout << "--" << __LINE__ << std::endl;
+
+//-----------------------------------------------------------------------------
+
+#define RUN_TIME         5 // s
+#define THREAD_BUDGET   16
+#define QUEUE_SIZE     128
+
+#define DELAY_TO_STR     1 // ms
+#define DELAY_TO_DBL     6 // ms
+#define DELAY_PRINT      1 // ms
+
+#define DELAY_REPORT   250 // ms
+
+//-----------------------------------------------------------------------------
+
+boost::mutex sum_mutex;
+double       sum = 0;
+
+std::string to_str( int i  )
+{
+    boost::this_thread::sleep_for( boost::chrono::milliseconds(DELAY_TO_STR) );
+    std::ostringstream oss;
+    oss << i;
+    return oss.str();
+}
+
+double to_dbl( std::string s )
+{
+    boost::this_thread::sleep_for( boost::chrono::milliseconds(DELAY_TO_DBL) );
+    return boost::lexical_cast<double>(s);
+}
+
+void print( double d )
+{
+    boost::this_thread::sleep_for( boost::chrono::milliseconds(DELAY_PRINT) );
+    boost::lock_guard<boost::mutex> lock(sum_mutex);
+    sum += d;
+}
+
+//-----------------------------------------------------------------------------
+
+typedef Active<int,std::string>    IntToStr;
+typedef Active<std::string,double> StrToDbl;
+typedef Active<double,void>        DblToVoid;
+
+void produce( IntToStr::Ptr ao )
+{
+    for( int i = 0; ; ++i )
+    {
+        try
+        {
+            boost::this_thread::interruption_point();
+            ao->send( i );
+        }
+        catch ( boost::thread_interrupted& e )
+        {
+            break;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+int main()
+{
+    std::cout << "> starting main" << std::endl;
+
+    IntToStr::Ptr  toStr = IntToStr::create( &to_str, 1, QUEUE_SIZE );
+    StrToDbl::Ptr  toDbl = StrToDbl::create( &to_dbl );
+    DblToVoid::Ptr pDbl  = DblToVoid::create( &print );
+
+    toStr | toDbl | pDbl;
+
+    PipeTuner tuner( THREAD_BUDGET, boost::chrono::milliseconds(DELAY_REPORT) );
+
+    tuner.add( toStr, "toStr" );
+    tuner.add( toDbl, "toDbl" );
+    tuner.add( pDbl,  "print" );
+
+    boost::thread producer( produce, toStr );
+
+    for( int i = 0; i < RUN_TIME * 1000 / DELAY_REPORT; ++i )
+    {
+        boost::this_thread::sleep_for( boost::chrono::milliseconds(DELAY_REPORT) );
+        tuner.tune();
+        tuner.print( std::cout );
+    }
+
+    producer.interrupt();
+    producer.join();
+
+    // destroy from the source, each stage drains into the next
+
+    toStr.reset();
+    toDbl.reset();
+    pDbl.reset();
+
+    std::cout << "> sum " << sum << std::endl;
+
+    std::cout << "> ending main" << std::endl;
+}
@@ -0,0 +1,90 @@
+/**
+ * Active Objects using boost
+ *
+ * Watchdog detecting workers stuck in a message
+ * Compensating with a replacement worker keeps the throughput
+ *
+ **/
+
+#define BOOST_THREAD_VERSION 3
+
+#include <iostream>
+
+#include <boost/chrono.hpp>
+
+#include "Watchdog.h"
+
+//-----------------------------------------------------------------------------
+
+#define HERE  std::cout << "--" << __LINE__ << std::endl;
+
+//-----------------------------------------------------------------------------
+
+#define N_MESSAGES    2000
+#define N_WORKERS        2
+#define DELAY_WORK     500 // us
+#define HANG          1500 // ms, the handler hangs on some messages
+#define HANG_EVERY     500
+
+#define THRESHOLD       50 // ms
+#define PERIOD          10 // ms
+
+//-----------------------------------------------------------------------------
+
+int handle( int i )
+{
+    if( i % HANG_EVERY == 1 )
+        boost::this_thread::sleep_for( boost::chrono::milliseconds(HANG) ); // e.g. a lost reply
+    else
+        boost::this_thread::sleep_for( boost::chrono::microseconds(DELAY_WORK) );
+    return i;
+}
+
+typedef Active<int,int> Handler;
+
+//-----------------------------------------------------------------------------
+
+void run( const std::string& name, bool compensate )
+{
+    Handler::Ptr ao = Handler::create( &handle, N_WORKERS );
+    ao->name( name );
+
+    Watchdog dog( boost::chrono::milliseconds(THRESHOLD), boost::chrono::milliseconds(PERIOD) );
+    dog.watch( ao, compensate );
+    dog.start();
+
+    boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now();
+
+    for( int i = 0; i < N_MESSAGES; ++i )
+        ao->send( i );
+
+    Handler::promise_ptr p( new Handler::promise_type() ); // fence, FIFO so all before it started
+    ao->send( 0, p );
+    p->get_future().get();
+
+    boost::chrono::duration<double> elapsed = boost::chrono::steady_clock::now() - start;
+
+    size_t peak = ao->tsize();
+
+    while( dog.stalled() ) // wait for the hung ones to recover
+        boost::this_thread::sleep_for( boost::chrono::milliseconds(PERIOD) );
+
+    size_t threads = ao->tsize();
+
+    std::cout << "> " << name
+              << " stalls " << dog.detected()
+              << " threads peak " << peak << " at the end " << threads
+              << " in " << elapsed.count() << " s" << std::endl;
+}
+
+//-----------------------------------------------------------------------------
+
+int main()
+{
+    std::cout << "> starting main" << std::endl;
+
+    run( "report only", false );
+    run( "compensate ", true );
+
+    std::cout << "> ending main" << std::endl;
+}
@@ -0,0 +1,212 @@
+#ifndef coalescing_queue_h
+#define coalescing_queue_h
+
+#include <list>
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+/// Queue keeping at most one item per key
+///
+/// Pushing an item whose key is already queued merges it into the queued one,
+/// which keeps its place in the queue. By default the newest item replaces the old one.
+/// The index makes both cases O(1).
+
+template< typename K, typename T >
+class coalescing_queue : private boost::noncopyable {
+
+public: // types
+
+    /// Merges an incoming item into the one already queued with the same key
+    typedef boost::function< void ( T& queued, const T& incoming ) > merge_type;
+
+private: // types
+
+    typedef std::pair<K,T>                                        entry_type;
+    typedef std::list< entry_type >                               list_type;
+    typedef boost::unordered_map< K, typename list_type::iterator > index_type;
+
+private: // data
+
+    bool   open_;           ///< if queue is accepting more entries
+    size_t max_;            ///< maximum nb of distinct keys in the queue
+
+    list_type  queue_;      ///< actual queue storage, in order of first push
+    index_type index_;      ///< position of each queued key
+
+    merge_type merge_;      ///< merges items with the same key
+    size_t     coalesced_;  ///< nb of items merged into queued ones
+
+    mutable boost::mutex m_;                ///< mutex for the queue's resource
+    boost::condition_variable data_cond_;   ///< condition variable for the queue resource
+
+public: // methods
+
+    /// Constructor
+    /// @param max nb of distinct keys in the queue, 0 is unlimited
+    /// @param merge function, by default the newest item replaces the queued one
+    coalescing_queue( size_t max = 0, merge_type merge = merge_type() ) :
+        open_(true),
+        max_(max),
+        merge_(merge),
+        coalesced_(0)
+    {
+    }
+
+    /// Merges the item if its key is queued, else waits (blocking)
+    /// until there is free space in the queue and then pushes the item
+    /// @returns true if item was pushed or merged, false if queue was closed
+    bool wait_and_push( const K& key, const T& item )
+    {
+        boost::unique_lock<boost::mutex> lock(m_);
+
+        if( open_ )
+        {
+            if( coalesce( key, item ) )
+                return true;
+
+            if( max_ )
+            {
+                while( queue_.size() >= max_ )
+                {
+                    data_cond_.wait(lock);
+                }
+                if( coalesce( key, item ) ) // may have been pushed while waiting
+                    return true;
+            }
+
+            insert( key, item );
+            data_cond_.notify_one();
+        }
+        return open_;
+    }
+
+    /// Forces an entry into the queue irrespective of size or open status
+    void push( const K& key, const T& item )
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        if( !coalesce( key, item ) )
+        {
+            insert( key, item );
+            data_cond_.notify_one();
+        }
+    }
+
+    /// Try to pop an item (blocking)
+    /// @returns true if item was poped, false if queue was empty and no item was poped
+    bool try_and_pop( T& item )
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        if( queue_.empty() ){
+            return false;
+        }
+        pop( item );
+        data_cond_.notify_one();
+        return true;
+    }
+
+    /// Wait (block) until there is an item to pop
+    void wait_and_pop( T& item )
+    {
+        boost::unique_lock<boost::mutex> lock(m_);
+        while( queue_.empty() )
+        {
+            data_cond_.wait(lock);
+        }
+        pop( item );
+        data_cond_.notify_one();
+    }
+
+    /// Open's the queue if it wasn't open
+    void open()
+    {
+        boost::unique_lock<boost::mutex> lock(m_);
+        if(!open_)
+            open_ = true;
+    }
+
+    /// Waits for queue to be emptied, then closes it
+    void drain_and_close()
+    {
+        boost::unique_lock<boost::mutex> lock(m_);
+        open_ = false; // don't accept more entries
+        while( !queue_.empty() )
+        {
+            data_cond_.wait(lock);
+        }
+        data_cond_.notify_one();
+    }
+
+    /// @returns if queue is open
+    bool is_open()
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        return open_;
+    }
+
+    /// @returns if queue is empty
+    bool empty() const
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        return queue_.empty();
+    }
+
+    /// @returns current nb of distinct keys in the queue
+    size_t size() const
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        return index_.size();
+    }
+
+    /// @returns nb of items merged into queued ones so far
+    size_t coalesced() const
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        return coalesced_;
+    }
+
+    /// @param maximum nb of distinct keys to set
+    void max_size( const size_t& s )
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        max_ = s;
+    }
+
+private: // methods
+
+    /// @returns true if key was queued and item merged into it
+    bool coalesce( const K& key, const T& item )
+    {
+        typename index_type::iterator itr = index_.find( key );
+        if( itr == index_.end() )
+            return false;
+
+        T& queued = itr->second->second;
+        if( merge_ )
+            merge_( queued, item );
+        else
+            queued = item;
+
+        ++coalesced_;
+        return true;
+    }
+
+    void insert( const K& key, const T& item )
+    {
+        queue_.push_back( entry_type( key, item ) );
+        index_[ key ] = --queue_.end();
+    }
+
+    void pop( T& item )
+    {
+        item = queue_.front().second;
+        index_.erase( queue_.front().first );
+        queue_.pop_front();
+    }
+
+};
+
+#endif
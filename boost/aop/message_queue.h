@@ -7,17 +7,114 @@
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/condition_variable.hpp>
 #include <boost/chrono.hpp>
+#include <boost/function.hpp>
 #include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+
+#include "TokenBucket.h"
+
+//-----------------------------------------------------------------------------
+
+/// Outcome of a non-blocking push
+enum admission_status
+{
+    ADMITTED = 0,       ///< item was queued
+    REJECTED_CLOSED,    ///< queue is closed
+    REJECTED_FULL,      ///< queue is full and the policy rejects the newest item
+    REJECTED_RATE,      ///< token bucket is empty
+    REJECTED_EARLY      ///< dropped early, oldest item waited too long
+};
+
+/// Policy applied by message_queue::try_push
+struct admission_policy
+{
+    enum overflow_type
+    {
+        REJECT_NEWEST,  ///< refuse the item being pushed
+        DROP_OLDEST     ///< discard the item at the front to make room
+    };
+
+    admission_policy() :
+        overflow(REJECT_NEWEST),
+        rate(0),
+        burst(1),
+        early_drop_min(0),
+        early_drop_max(0)
+    {
+    }
+
+    overflow_type              overflow;        ///< what to do when the queue is full
+    double                     rate;            ///< items admitted per second, 0 is unlimited
+    double                     burst;           ///< items admitted at once above the rate
+    boost::chrono::nanoseconds early_drop_min;  ///< residence time of the oldest item where drops start, 0 disables
+    boost::chrono::nanoseconds early_drop_max;  ///< residence time where all items are dropped
+};
+
+/// Counters of the admission decisions
+struct admission_counters
+{
+    admission_counters() :
+        admitted(0),
+        rejected_closed(0),
+        rejected_full(0),
+        rejected_rate(0),
+        rejected_early(0),
+        dropped_oldest(0)
+    {
+    }
+
+    /// @returns nb of items refused or discarded by the policy
+    /// Items refused by a closed queue are only counted in rejected_closed
+    size_t dropped() const
+    {
+        return rejected_full + rejected_rate + rejected_early + dropped_oldest;
+    }
+
+    size_t admitted;
+    size_t rejected_closed;   ///< refused because the queue was closed, not by the policy
+    size_t rejected_full;
+    size_t rejected_rate;
+    size_t rejected_early;
+    size_t dropped_oldest;
+};
+
+//-----------------------------------------------------------------------------
 
 template<typename T>
 class message_queue : private boost::noncopyable {
 
+public: // types
+
+    typedef boost::chrono::steady_clock clock_type;
+
+    typedef boost::function< void ( T& ) > drop_handler;
+
+private: // types
+
+    struct entry
+    {
+        entry( const T& i, clock_type::time_point t ) : item(i), stamp(t) {}
+
+        T                       item;
+        clock_type::time_point  stamp;  ///< time of push, only set for early drop
+    };
+
 private: // data
 
     bool   open_;           ///< if queue is accepting more entries
     size_t max_;            ///< maximum size of queue
+    size_t blocked_;        ///< nb of wait_and_push callers waiting for room
+
+    std::queue<entry> queue_;   ///< actual queue storage
+
+    admission_policy    policy_;    ///< policy for try_push
+    TokenBucket         bucket_;    ///< rate limiter for try_push
+    admission_counters  counters_;  ///< admission decisions of try_push
+    drop_handler        on_drop_;   ///< called for items discarded from the queue
 
-    std::queue<T> queue_;   ///< actual queue storage
+    boost::scoped_ptr< boost::random::mt19937 > gen_;  ///< random source, only allocated for early drop
 
     mutable boost::mutex m_;                ///< mutex for the queue's resource
     boost::condition_variable data_cond_;   ///< condition variable for the queue resource
@@ -28,7 +125,8 @@ public: // methods
     /// @param max size of the queue, 0 is unlimited
     message_queue( size_t max = 0 ) :
         open_(true),
-        max_(max)
+        max_(max),
+        blocked_(0)
     {
     }
 
@@ -47,25 +145,89 @@ public: // methods
         {
             if( max_ )
             {
-                while( queue_.size() >= max_ )
+                if( queue_.size() >= max_ )
                 {
-                    data_cond_.wait(lock);
+                    ++blocked_;
+                    while( queue_.size() >= max_ )
+                    {
+                        data_cond_.wait(lock);
+                    }
+                    --blocked_;
                 }
             }
 
-            queue_.push(item);
+            queue_.push( entry( item, stamp() ) );
             data_cond_.notify_one();
 
         }
         return open_;
     }
 
+    /// Pushes an item if the admission policy allows it, never blocks
+    /// The rate token is consumed last, only by an item the other checks let through
+    /// @returns ADMITTED if item was pushed, else the reason it was rejected
+    admission_status try_push( T item )
+    {
+        boost::unique_lock<boost::mutex> lock(m_);
+
+        if( !open_ )
+        {
+            ++counters_.rejected_closed;
+            return REJECTED_CLOSED;
+        }
+
+        bool full = max_ && queue_.size() >= max_;
+
+        if( full && policy_.overflow == admission_policy::REJECT_NEWEST )
+        {
+            ++counters_.rejected_full;
+            return REJECTED_FULL;
+        }
+
+        if( early_drop() )
+        {
+            ++counters_.rejected_early;
+            return REJECTED_EARLY;
+        }
+
+        if( !bucket_.consume() )
+        {
+            ++counters_.rejected_rate;
+            return REJECTED_RATE;
+        }
+
+        if( full )
+        {
+            T oldest = queue_.front().item;
+            queue_.pop();
+            queue_.push( entry( item, stamp() ) );
+
+            ++counters_.dropped_oldest;
+            ++counters_.admitted;
+
+            drop_handler h = on_drop_;
+            lock.unlock();
+
+            if( h )
+                h( oldest );
+
+            return ADMITTED;
+        }
+
+        queue_.push( entry( item, stamp() ) );
+        data_cond_.notify_one();
+
+        ++counters_.admitted;
+
+        return ADMITTED;
+    }
+
     /// Forces an entry into the queue irrespective of size or open status
     /// This means that queue may sometimes have more items than its max value
     void push( T item )
     {
         boost::lock_guard<boost::mutex> lock(m_);
-        queue_.push(item);
+        queue_.push( entry( item, stamp() ) );
         data_cond_.notify_one();
     }
 
@@ -77,7 +239,7 @@ public: // methods
         if(queue_.empty()){
             return false;
         }
-        item = queue_.front();
+        item = queue_.front().item;
         queue_.pop();
         data_cond_.notify_one();
         return true;
@@ -91,7 +253,7 @@ public: // methods
         {
             data_cond_.wait(lock);
         }
-        item = queue_.front();
+        item = queue_.front().item;
         queue_.pop();
         data_cond_.notify_one();
     }
@@ -137,6 +299,20 @@ public: // methods
         return queue_.size();
     }
 
+    /// @returns the maximum size of the queue, 0 is unlimited
+    size_t max_size() const
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        return max_;
+    }
+
+    /// @returns the nb of senders blocked in wait_and_push, waiting for room
+    size_t blocked() const
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        return blocked_;
+    }
+
     /// @param maximum size of queue to set
     void max_size( const size_t& s )
     {
@@ -144,6 +320,62 @@ public: // methods
         max_ = s;
     }
 
+    /// Sets the policy applied by try_push
+    void admission( const admission_policy& p )
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        policy_ = p;
+        bucket_ = TokenBucket( p.rate, p.burst );
+        if( p.early_drop_min.count() && !gen_ )
+            gen_.reset( new boost::random::mt19937() );
+    }
+
+    /// @returns the admission decisions of try_push
+    admission_counters counters() const
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        return counters_;
+    }
+
+    /// Sets the function called for items discarded by the DROP_OLDEST policy
+    void on_drop( const drop_handler& h )
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        on_drop_ = h;
+    }
+
+private: // methods
+
+    /// @returns the time to stamp an entry, only taken if early drop needs it
+    clock_type::time_point stamp() const
+    {
+        return policy_.early_drop_min.count() ? clock_type::now() : clock_type::time_point();
+    }
+
+    /// Decides to drop with a probability growing with the residence time of the oldest item
+    /// @returns true if the item should be dropped
+    bool early_drop()
+    {
+        if( !policy_.early_drop_min.count() || queue_.empty() )
+            return false;
+
+        clock_type::time_point t = queue_.front().stamp;
+        if( t == clock_type::time_point() )
+            return false;
+
+        boost::chrono::nanoseconds residence = clock_type::now() - t;
+
+        if( residence <= policy_.early_drop_min )
+            return false;
+        if( residence >= policy_.early_drop_max )
+            return true;
+
+        double p = double( ( residence - policy_.early_drop_min ).count() ) /
+                   double( ( policy_.early_drop_max - policy_.early_drop_min ).count() );
+
+        return boost::random::uniform_real_distribution<>(0,1)(*gen_) < p;
+    }
+
 };
 
 #endif
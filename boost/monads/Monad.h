@@ -0,0 +1,99 @@
+#ifndef Monad_h
+#define Monad_h
+
+//-----------------------------------------------------------------------------
+
+/// Unit lifts a value into the chain
+template < typename T >
+struct Unit {
+
+    typedef T result_type;
+
+    Unit( const T& v ) : v_(v) {}
+    T operator()()
+    {
+        return v_;
+    }
+
+private:
+    T v_;
+};
+
+template < typename V >
+Unit<V> U( const V& v ) { return Unit<V>(v); }
+
+//-----------------------------------------------------------------------------
+
+/// Monad applies f to the value produced by v
+template < typename F, typename V >
+struct Monad {
+
+    typedef typename F::result_type result_type;
+    typedef typename F::argument_type argument_type;
+
+    Monad( const F& f, const V& v ) : f_(f), v_(v) {}
+    typename F::result_type operator()()
+    {
+        return f_( v_() );
+    }
+
+    const F& f() const { return f_; }
+    const V& v() const { return v_; }
+
+private:
+    F f_;
+    V v_;
+};
+
+//-----------------------------------------------------------------------------
+
+/// Composition f . g keeping both concrete types, so the call to each inlines
+template < typename F, typename G >
+struct Composed {
+
+    typedef typename F::result_type result_type;
+    typedef typename G::argument_type argument_type;
+
+    Composed( const F& f, const G& g ) : f_(f), g_(g) {}
+
+    result_type operator()( argument_type a ) const
+    {
+        return f_( g_( a ) );
+    }
+
+private:
+    F f_;
+    G g_;
+};
+
+/// Function known at compile time, as a function object of its own type
+/// Unlike a function pointer or a boost::function, calls to it are direct and inline
+template < typename R, typename A, R (*f)( A ) >
+struct Fn {
+
+    typedef R result_type;
+    typedef A argument_type;
+
+    R operator()( A a ) const { return f( a ); }
+};
+
+//-----------------------------------------------------------------------------
+
+template < typename F, typename V >
+Monad<F,V> M( const F& f, const V& v ) { return Monad<F,V>(f,v); }
+
+/// Like M, but fuse(f, fuse(g, v)) builds M(f . g, v): a single function object with
+/// no intermediate layer, so a whole statically known chain becomes one inlined call.
+/// Opt in, M alone always nests, and keeps the types it builds as they are.
+template < typename F, typename V >
+Monad<F,V> fuse( const F& f, const V& v ) { return Monad<F,V>(f,v); }
+
+template < typename F, typename G, typename V >
+Monad< Composed<F,G>, V > fuse( const F& f, const Monad<G,V>& m )
+{
+    return Monad< Composed<F,G>, V >( Composed<F,G>( f, m.f() ), m.v() );
+}
+
+//-----------------------------------------------------------------------------
+
+#endif
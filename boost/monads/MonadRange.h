@@ -0,0 +1,173 @@
+#ifndef MonadRange_h
+#define MonadRange_h
+
+#include <algorithm>
+#include <iterator>
+
+#include <boost/bind.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "Monad.h"
+
+//-----------------------------------------------------------------------------
+
+/// Stands for each element of a range at the bottom of a chain
+/// fuse(f, fuse(g, Each<T>())) builds the single function f . g, applied by map_range
+template < typename T >
+struct Each {
+
+    typedef T result_type;
+};
+
+template < typename T >
+Each<T> each() { return Each<T>(); }
+
+/// Never stops a map_range
+struct NoStop {
+
+    template < typename R >
+    bool operator()( const R& ) const { return false; }
+};
+
+//-----------------------------------------------------------------------------
+
+namespace detail {
+
+/// Applies f over a range, chunk by chunk, in several threads
+///
+/// Threads take the next chunk from a shared index, so they balance themselves.
+/// Results go to the same position in the output, so the order is preserved.
+/// Once a result satisfies stop, chunks after it are skipped and the output ends
+/// just after the first stopping result, in range order.
+
+template < typename F, typename In, typename Out, typename Stop >
+class RangeMap {
+
+public: // methods
+
+    RangeMap( F f, In first, In last, Out out, Stop stop, size_t chunk ) :
+        f_(f),
+        first_(first),
+        out_(out),
+        stop_(stop),
+        n_( std::distance( first, last ) ),
+        chunk_(chunk),
+        next_(0),
+        end_(n_)
+    {
+    }
+
+    /// @returns the nb of results written
+    size_t run( size_t nb_threads )
+    {
+        boost::thread_group threads;
+        for( size_t i = 1; i < nb_threads; ++i )
+            threads.create_thread( boost::bind( &RangeMap::work, this ) );
+
+        work(); // the calling thread helps
+
+        threads.join_all();
+        return end_;
+    }
+
+private: // methods
+
+    /// @returns the start of the next chunk to map, or n_ if there is none left
+    size_t take()
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        size_t b = next_;
+        if( b >= end_ ) // past the first stop, or finished
+            return n_;
+        next_ += chunk_;
+        return b;
+    }
+
+    /// Records a stop at position i, keeping the earliest
+    void stop_at( size_t i )
+    {
+        boost::lock_guard<boost::mutex> lock(m_);
+        end_ = std::min( end_, i + 1 );
+    }
+
+    void work()
+    {
+        for( size_t b = take(); b < n_; b = take() )
+        {
+            size_t e = std::min( b + chunk_, n_ );
+
+            In  in  = first_ + b;
+            Out out = out_   + b;
+            for( size_t i = b; i < e; ++i, ++in, ++out )
+            {
+                *out = f_( *in );
+                if( stop_( *out ) )
+                {
+                    stop_at( i );
+                    break;
+                }
+            }
+        }
+    }
+
+private: // data
+
+    boost::mutex  m_;       ///< mutex for next_ and end_, taken once per chunk
+
+    F             f_;       ///< the fused chain
+    In            first_;
+    Out           out_;
+    Stop          stop_;
+
+    size_t        n_;       ///< size of the range
+    size_t        chunk_;   ///< nb elements per chunk
+    size_t        next_;    ///< start of the next chunk to take
+    size_t        end_;     ///< nb results to keep, shrinks on stops
+
+};
+
+}
+
+//-----------------------------------------------------------------------------
+
+/// Maps f over [first,last) into out, in parallel and in order, until a result satisfies stop
+/// In and Out are random access iterators
+/// @param nb_threads is the nb threads to use, 0 for one per core
+/// @param chunk is the nb elements each thread takes at a time, 0 for a cache sized chunk
+/// @returns the end of the results: just after the first result satisfying stop, or out + (last - first)
+template < typename F, typename In, typename Out, typename Stop >
+Out map_range_until( F f, In first, In last, Out out, Stop stop, size_t nb_threads = 0, size_t chunk = 0 )
+{
+    if( !nb_threads )
+        nb_threads = std::max< unsigned >( 1, boost::thread::hardware_concurrency() );
+    if( !chunk )
+        chunk = std::max< size_t >( 1, 32 * 1024 / ( sizeof(*first) + sizeof(*out) ) ); // input and output fit in L1
+
+    detail::RangeMap<F,In,Out,Stop> rm( f, first, last, out, stop, chunk );
+    return out + rm.run( nb_threads );
+}
+
+/// Maps f over [first,last) into out, in parallel and in order
+template < typename F, typename In, typename Out >
+Out map_range( F f, In first, In last, Out out, size_t nb_threads = 0, size_t chunk = 0 )
+{
+    return map_range_until( f, first, last, out, NoStop(), nb_threads, chunk );
+}
+
+/// Maps a chain fused over Each<T> over a range, see fuse
+template < typename F, typename T, typename In, typename Out >
+Out map_range( const Monad< F, Each<T> >& m, In first, In last, Out out, size_t nb_threads = 0, size_t chunk = 0 )
+{
+    return map_range_until( m.f(), first, last, out, NoStop(), nb_threads, chunk );
+}
+
+template < typename F, typename T, typename In, typename Out, typename Stop >
+Out map_range_until( const Monad< F, Each<T> >& m, In first, In last, Out out, Stop stop, size_t nb_threads = 0, size_t chunk = 0 )
+{
+    return map_range_until( m.f(), first, last, out, stop, nb_threads, chunk );
+}
+
+//-----------------------------------------------------------------------------
+
+#endif
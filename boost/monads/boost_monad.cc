@@ -5,46 +5,7 @@
 #include <boost/function.hpp>
 #include <boost/lexical_cast.hpp>
 
-//-----------------------------------------------------------------------------
-
-template < typename T >
-struct Unit {
-    Unit( const T& v ) : v_(v) {}
-    T operator()()
-    {
-        return v_;
-    }
-
-private:
-    T v_;
-};
-
-template < typename V >
-Unit<V> U( const V& v ) { return Unit<V>(v); }
-
-//-----------------------------------------------------------------------------
-
-template < typename F, typename V >
-struct Monad {
-
-    typedef typename F::result_type result_type;
-    typedef typename F::argument_type argument_type;
-
-    Monad( const F& f, const V& v ) : f_(f), v_(v) {}
-    typename F::result_type operator()()
-    {
-        return f_( v_() );
-    }
-
-private:
-    F f_;
-    V v_;
-};
-
-template < typename F, typename V >
-Monad<F,V> M( const F& f, const V& v ) { return Monad<F,V>(f,v); }
-
-//-----------------------------------------------------------------------------
+#include "Monad.h"
 
 //-----------------------------------------------------------------------------
 
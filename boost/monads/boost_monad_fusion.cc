@@ -0,0 +1,98 @@
+/**
+ * Fused vs type erased Monad chains
+ *
+ * The same 16 level chain, once built at run time through boost::function,
+ * once known statically, where fuse(f, fuse(g, ...)) builds a single function object
+ *
+ **/
+
+#include <iostream>
+#include <string>
+
+#include <boost/chrono.hpp>
+#include <boost/function.hpp>
+
+#include "Monad.h"
+
+//-----------------------------------------------------------------------------
+
+#define HERE  std::cout << "--" << __LINE__ << std::endl;
+
+//-----------------------------------------------------------------------------
+
+#define N_EVAL  10000000
+
+//-----------------------------------------------------------------------------
+
+int inc  ( int i ) { return i + 1; }
+int dec2 ( int i ) { return i - 2; }
+
+/// Produces 0, 1, 2, ... through a volatile, so evaluations cannot be folded away
+struct Counter {
+
+    typedef int result_type;
+
+    Counter( volatile int* p ) : p_(p) {}
+    int operator()() { return (*p_)++; }
+
+private:
+    volatile int* p_;
+};
+
+//-----------------------------------------------------------------------------
+
+typedef boost::chrono::steady_clock clock_type;
+
+template < typename C >
+long long evaluate( const std::string& what, C c )
+{
+    clock_type::time_point start = clock_type::now();
+
+    long long sum = 0;
+    for( int i = 0; i < N_EVAL; ++i )
+        sum += c();
+
+    boost::chrono::duration<double> elapsed = clock_type::now() - start;
+
+    std::cout << "> " << what << " : sum " << sum << " in " << elapsed.count() << " s, "
+              << (long long)( N_EVAL / elapsed.count() ) << " chains/s" << std::endl;
+    return sum;
+}
+
+//-----------------------------------------------------------------------------
+
+#define PAIR(v)  fuse( fi, fuse( fd, v ) )
+
+int main()
+{
+    std::cout << "> starting main" << std::endl;
+
+    // run time chain, each level a boost::function wrapping the one below
+
+    volatile int x = 0;
+
+    boost::function< int ( int ) > bi = &inc;
+    boost::function< int ( int ) > bd = &dec2;
+
+    boost::function< int () > dyn = Counter(&x);
+    for( int i = 0; i < 8; ++i )
+    {
+        dyn = M( bi, dyn );
+        dyn = M( bd, dyn );
+    }
+
+    long long s1 = evaluate( "boost::function chain", dyn );
+
+    // static chain, fused into Monad< Composed< Fn<inc>, Composed< Fn<dec2>, ... > >, Counter >
+
+    volatile int y = 0;
+
+    Fn< int, int, &inc >  fi;
+    Fn< int, int, &dec2 > fd;
+
+    long long s2 = evaluate( "fused static chain   ", PAIR(PAIR(PAIR(PAIR(PAIR(PAIR(PAIR(PAIR( Counter(&y) )))))))) );
+
+    std::cout << "> results " << ( s1 == s2 ? "match" : "DIFFER" ) << std::endl;
+
+    std::cout << "> ending main" << std::endl;
+}
@@ -0,0 +1,102 @@
+/**
+ * Monad chains over ranges
+ *
+ * A chain fused over each<T>() is one function, mapped over a large
+ * range in cache sized chunks, by all cores, preserving the order
+ *
+ **/
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/chrono.hpp>
+#include <boost/function.hpp>
+
+#include "MonadRange.h"
+
+//-----------------------------------------------------------------------------
+
+#define HERE  std::cout << "--" << __LINE__ << std::endl;
+
+//-----------------------------------------------------------------------------
+
+#define N_RECORDS  (1 << 24)
+#define STOP_AT    (N_RECORDS / 3)
+
+//-----------------------------------------------------------------------------
+
+int inc    ( int i ) { return i + 1; }
+int times3 ( int i ) { return 3 * i; }
+int dec2   ( int i ) { return i - 2; }
+
+/// Stops at the first result above a threshold
+struct Above {
+
+    Above( int t ) : t_(t) {}
+    bool operator()( int r ) const { return r > t_; }
+
+private:
+    int t_;
+};
+
+//-----------------------------------------------------------------------------
+
+typedef boost::chrono::steady_clock clock_type;
+
+void report( const std::string& what, size_t n, clock_type::time_point start )
+{
+    boost::chrono::duration<double> elapsed = clock_type::now() - start;
+    std::cout << "> " << what << " : " << n << " records in " << elapsed.count() << " s, "
+              << (long long)( n / elapsed.count() ) << " records/s" << std::endl;
+}
+
+int main()
+{
+    std::cout << "> starting main" << std::endl;
+
+    std::vector<int> in( N_RECORDS );
+    for( size_t i = 0; i < in.size(); ++i )
+        in[i] = int(i);
+
+    std::vector<int> r1( N_RECORDS );
+    std::vector<int> r2( N_RECORDS );
+
+    // one boxed value at a time, as in boost_monad
+
+    boost::function< int ( int ) > bi = &inc;
+    boost::function< int ( int ) > bt = &times3;
+    boost::function< int ( int ) > bd = &dec2;
+
+    clock_type::time_point start = clock_type::now();
+    for( size_t i = 0; i < in.size(); ++i )
+        r1[i] = M( bd, M( bt, M( bi, U( in[i] ) ) ) )();
+    report( "one value at a time ", in.size(), start );
+
+    // fused chain over the whole range
+
+    Fn< int, int, &inc >    fi;
+    Fn< int, int, &times3 > ft;
+    Fn< int, int, &dec2 >   fd;
+
+    start = clock_type::now();
+    map_range( fuse( fd, fuse( ft, fuse( fi, each<int>() ) ) ), in.begin(), in.end(), r2.begin() );
+    report( "map_range           ", in.size(), start );
+
+    std::cout << "> results " << ( r1 == r2 ? "match" : "DIFFER" ) << std::endl;
+
+    // early termination, the output ends at the first result above the threshold
+
+    std::vector<int> r3( N_RECORDS );
+
+    start = clock_type::now();
+    std::vector<int>::iterator end =
+        map_range_until( fuse( fd, fuse( ft, fuse( fi, each<int>() ) ) ), in.begin(), in.end(), r3.begin(), Above( 3 * STOP_AT ) );
+    size_t n = end - r3.begin();
+    report( "map_range_until     ", n, start );
+
+    std::cout << "> stopped after " << n << " records, at " << r3[n-1]
+              << ( n == size_t( STOP_AT + 1 ) ? ", as expected" : ", UNEXPECTED" ) << std::endl;
+
+    std::cout << "> ending main" << std::endl;
+}
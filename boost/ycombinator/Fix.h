@@ -0,0 +1,46 @@
+#ifndef Fix_h
+#define Fix_h
+
+//-----------------------------------------------------------------------------
+
+/// Fixpoint of an open recursive function object, with no type erasure
+///
+/// f is called as f( self, args... ), self being a reference to this Fix, so a
+/// recursive call is a direct call of a known type: no boost::function, no bind,
+/// no allocation, and the compiler can inline it as for plain recursion.
+/// f has a result_type and an operator() templated on the type of self,
+/// for any argument types and up to three arguments.
+
+template < typename F >
+class Fix {
+
+public: // types
+
+    typedef typename F::result_type result_type;
+
+public: // methods
+
+    explicit Fix( const F& f ) : f_(f) {}
+
+    template < typename A1 >
+    result_type operator()( const A1& a1 ) const { return f_( *this, a1 ); }
+
+    template < typename A1, typename A2 >
+    result_type operator()( const A1& a1, const A2& a2 ) const { return f_( *this, a1, a2 ); }
+
+    template < typename A1, typename A2, typename A3 >
+    result_type operator()( const A1& a1, const A2& a2, const A3& a3 ) const { return f_( *this, a1, a2, a3 ); }
+
+private: // data
+
+    F f_;
+
+};
+
+/// @returns the fixpoint of f
+template < typename F >
+Fix<F> fix( const F& f ) { return Fix<F>(f); }
+
+//-----------------------------------------------------------------------------
+
+#endif
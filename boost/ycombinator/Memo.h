@@ -0,0 +1,261 @@
+#ifndef Memo_h
+#define Memo_h
+
+#ifndef BOOST_THREAD_VERSION
+#define BOOST_THREAD_VERSION 3
+#endif
+
+#include <list>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/future.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
+
+//-----------------------------------------------------------------------------
+
+/// Thread safe memo table, split in shards each with its own mutex
+///
+/// Each shard keeps at most its share of the max size, evicting the least recently
+/// used entries. Optionally the first thread to miss a key computes it while the others
+/// wait for its result, instead of all computing it at the same time.
+
+template < typename K, typename V >
+class MemoTable : private boost::noncopyable {
+
+public: // types
+
+    typedef boost::shared_future<V>  future_type;
+
+private: // types
+
+    typedef std::list< std::pair<K,V> >                      lru_type;   ///< most recent first
+    typedef boost::unordered_map< K, typename lru_type::iterator, boost::hash<K> > index_type;
+
+    typedef boost::shared_ptr< boost::promise<V> >           promise_ptr;
+    typedef boost::unordered_map< K, future_type, boost::hash<K> > inflight_type;
+
+    struct Shard
+    {
+        Shard() : hits(0), misses(0) {}
+
+        boost::mutex   m;
+        lru_type       lru;
+        index_type     index;
+        inflight_type  inflight;   ///< keys being computed
+        size_t         hits;
+        size_t         misses;
+    };
+
+private: // data
+
+    std::vector< boost::shared_ptr<Shard> > shards_;
+
+    size_t  max_;        ///< max entries per shard, 0 is unlimited
+    bool    per_key_;    ///< only one thread computes each key
+
+public: // methods
+
+    /// Constructor
+    /// @param max_size is the max nb of entries, 0 is unlimited
+    /// @param per_key makes threads missing a key being computed wait for it
+    MemoTable( size_t max_size = 0, bool per_key = true, size_t nb_shards = 16 ) :
+        max_( max_size ? ( max_size + nb_shards - 1 ) / nb_shards : 0 ),
+        per_key_( per_key )
+    {
+        for( size_t i = 0; i < nb_shards; ++i )
+            shards_.push_back( boost::shared_ptr<Shard>( new Shard() ) );
+    }
+
+    /// @returns the value of k, calling compute( k ) on a miss
+    template < typename F >
+    V get( const K& k, F compute )
+    {
+        Shard& s = shard(k);
+
+        promise_ptr p;
+        future_type f;
+        {
+            boost::lock_guard<boost::mutex> lock(s.m);
+
+            typename index_type::iterator itr = s.index.find(k);
+            if( itr != s.index.end() )
+            {
+                ++s.hits;
+                s.lru.splice( s.lru.begin(), s.lru, itr->second );
+                return itr->second->second;
+            }
+
+            ++s.misses;
+
+            if( per_key_ )
+            {
+                typename inflight_type::iterator i = s.inflight.find(k);
+                if( i != s.inflight.end() )
+                    f = i->second;
+                else
+                {
+                    p = promise_ptr( new boost::promise<V>() );
+                    s.inflight[k] = p->get_future().share();
+                }
+            }
+        }
+
+        if( f.valid() ) // another thread is computing it
+            return f.get();
+
+        V v;
+        try
+        {
+            v = compute( k ); // unlocked, may recurse into the table
+        }
+        catch( ... )
+        {
+            if( p )
+            {
+                p->set_exception( boost::current_exception() );
+                boost::lock_guard<boost::mutex> lock(s.m);
+                s.inflight.erase(k);
+            }
+            throw;
+        }
+
+        {
+            boost::lock_guard<boost::mutex> lock(s.m);
+            insert( s, k, v );
+            if( p )
+                s.inflight.erase(k);
+        }
+
+        if( p )
+            p->set_value(v);
+
+        return v;
+    }
+
+    /// @returns the nb of entries
+    size_t size() const { return sum( &Shard::index ); }
+
+    size_t hits()   const { return count( &Shard::hits ); }
+    size_t misses() const { return count( &Shard::misses ); }
+
+    void clear()
+    {
+        for( size_t i = 0; i < shards_.size(); ++i )
+        {
+            boost::lock_guard<boost::mutex> lock( shards_[i]->m );
+            shards_[i]->lru.clear();
+            shards_[i]->index.clear();
+        }
+    }
+
+private: // methods
+
+    Shard& shard( const K& k ) { return *shards_[ boost::hash<K>()(k) % shards_.size() ]; }
+
+    void insert( Shard& s, const K& k, const V& v )
+    {
+        if( s.index.count(k) ) // computed meanwhile by another thread
+            return;
+
+        s.lru.push_front( std::make_pair(k, v) );
+        s.index[k] = s.lru.begin();
+
+        if( max_ && s.lru.size() > max_ )
+        {
+            s.index.erase( s.lru.back().first );
+            s.lru.pop_back();
+        }
+    }
+
+    size_t sum( index_type Shard::* m ) const
+    {
+        size_t n = 0;
+        for( size_t i = 0; i < shards_.size(); ++i )
+        {
+            boost::lock_guard<boost::mutex> lock( shards_[i]->m );
+            n += ( (*shards_[i]).*m ).size();
+        }
+        return n;
+    }
+
+    size_t count( size_t Shard::* m ) const
+    {
+        size_t n = 0;
+        for( size_t i = 0; i < shards_.size(); ++i )
+        {
+            boost::lock_guard<boost::mutex> lock( shards_[i]->m );
+            n += (*shards_[i]).*m;
+        }
+        return n;
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+
+/// Fixpoint of an open recursive function, with every result memoized
+///
+/// The recursive calls f receives go through the memo table, so each argument is
+/// computed once, and the table is shared by all threads calling this object.
+/// Unlike ycomb, the self reference is bound once, not on every call.
+
+template < typename K, typename V >
+class Memoized : private boost::noncopyable {
+
+public: // types
+
+    typedef boost::shared_ptr< Memoized<K,V> > Ptr;
+
+    typedef boost::function< V ( K ) >                   self_type;
+    typedef boost::function< V ( self_type, K ) >        open_type;
+
+public: // methods
+
+    Memoized( open_type f, size_t max_size = 0, bool per_key = true, size_t nb_shards = 16 ) :
+        f_(f),
+        table_( max_size, per_key, nb_shards )
+    {
+        self_ = boost::bind( &Memoized<K,V>::operator(), this, _1 );
+    }
+
+    V operator()( K k )
+    {
+        return table_.get( k, boost::bind( f_, boost::cref(self_), _1 ) );
+    }
+
+    MemoTable<K,V>& table() { return table_; }
+
+    /// Factory method
+    static Ptr create( open_type f, size_t max_size = 0, bool per_key = true, size_t nb_shards = 16 )
+    {
+        return Ptr( new Memoized<K,V>( f, max_size, per_key, nb_shards ) );
+    }
+
+private: // data
+
+    open_type       f_;
+    self_type       self_;    ///< calls back into this object
+    MemoTable<K,V>  table_;
+
+};
+
+/// Memoizing Y-combinator
+/// @returns the fixpoint of f, sharing one memo table between all its copies
+template < typename K, typename V >
+boost::function< V ( K ) > ycomb_memo( boost::function< V ( boost::function< V ( K ) >, K ) > f,
+                                       size_t max_size = 0,
+                                       bool per_key = true )
+{
+    typename Memoized<K,V>::Ptr m = Memoized<K,V>::create( f, max_size, per_key );
+    return boost::bind( &Memoized<K,V>::operator(), m, _1 );
+}
+
+//-----------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,294 @@
+#ifndef Parallel_h
+#define Parallel_h
+
+#ifndef BOOST_THREAD_VERSION
+#define BOOST_THREAD_VERSION 3
+#endif
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <boost/exception_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/tss.hpp>
+
+//-----------------------------------------------------------------------------
+
+/// Pool of threads each with its own deque of tasks
+///
+/// A worker pushes and pops tasks at the back of its own deque, so it works depth
+/// first on what it spawned last, while idle workers steal from the front of the
+/// others, taking the oldest and so largest tasks. A thread waiting for tasks to
+/// finish runs tasks meanwhile, so nested waits never block the pool.
+
+class StealingPool : private boost::noncopyable {
+
+public: // types
+
+    typedef boost::function< void () > work_type;
+
+private: // types
+
+    struct Worker
+    {
+        boost::mutex           m;
+        std::deque<work_type>  q;
+    };
+
+private: // data
+
+    std::vector< boost::shared_ptr<Worker> > workers_;
+
+    boost::thread_specific_ptr<size_t>  self_;     ///< index of the calling worker, unset outside the pool
+    boost::atomic<size_t>               next_;     ///< round robin for tasks pushed from outside
+    boost::atomic<bool>                 done_;     ///< flag for finishing
+
+    boost::thread_group                 threads_;
+
+public: // methods
+
+    /// Constructor
+    /// Starts one worker per core by default
+    StealingPool( size_t nb_threads = 0 ) : next_(0), done_(false)
+    {
+        if( !nb_threads )
+            nb_threads = std::max<unsigned>( 1, boost::thread::hardware_concurrency() );
+
+        for( size_t i = 0; i < nb_threads; ++i )
+            workers_.push_back( boost::shared_ptr<Worker>( new Worker() ) );
+        for( size_t i = 0; i < nb_threads; ++i )
+            threads_.create_thread( boost::bind( &StealingPool::run, this, i ) );
+    }
+
+    /// Destructor
+    /// Tasks still queued are discarded
+    ~StealingPool()
+    {
+        done_ = true;
+        threads_.join_all();
+    }
+
+    /// Queues a task on the calling worker, or on some worker if called from outside the pool
+    void push( const work_type& w )
+    {
+        size_t i = self_.get() ? *self_ : next_++ % workers_.size();
+
+        boost::lock_guard<boost::mutex> lock( workers_[i]->m );
+        workers_[i]->q.push_back(w);
+    }
+
+    /// Runs tasks until pending drops to zero
+    void help_until( const boost::atomic<int>& pending )
+    {
+        while( pending.load( boost::memory_order_acquire ) > 0 )
+            if( !run_one() )
+                boost::this_thread::yield();
+    }
+
+    /// @returns the nb worker threads
+    size_t size() const { return workers_.size(); }
+
+private: // methods
+
+    /// Runs one task, from the calling worker's own deque first, else stolen
+    /// @returns false if no task was found
+    bool run_one()
+    {
+        work_type w;
+
+        size_t n = workers_.size();
+        size_t self = self_.get() ? *self_ : n;
+
+        if( self < n )
+        {
+            Worker& me = *workers_[self];
+            boost::lock_guard<boost::mutex> lock( me.m );
+            if( !me.q.empty() )
+            {
+                w.swap( me.q.back() );
+                me.q.pop_back();
+            }
+        }
+
+        for( size_t k = 1; !w && k <= n; ++k )
+        {
+            Worker& victim = *workers_[ ( self + k ) % n ];
+            boost::lock_guard<boost::mutex> lock( victim.m );
+            if( !victim.q.empty() )
+            {
+                w.swap( victim.q.front() );
+                victim.q.pop_front();
+            }
+        }
+
+        if( !w )
+            return false;
+
+        w();
+        return true;
+    }
+
+    void run( size_t i )
+    {
+        self_.reset( new size_t(i) );
+        while( !done_ )
+            if( !run_one() )
+                boost::this_thread::yield();
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+
+/// Fixpoint of an open recursive function, with explicit fork/join recursion
+///
+/// f gets a Self instead of a plain recursion: self(k) calls the fixpoint inline,
+/// self.spawn(k) starts a call that runs concurrently, and self.join(s) waits for it,
+/// running pool tasks meanwhile, and returns its result or rethrows its exception.
+/// Above the cutoff spawned calls are tasks on the pool, up to it they are evaluated
+/// right away, so small arguments recurse serially with no task overhead.
+///
+/// f runs once per call, on real results only. Calls whose arguments depend on earlier
+/// results, like Ackermann's or Hofstadter's, join the earlier ones first and still
+/// spawn the calls that are independent. Every spawned call must be joined.
+
+template < typename K, typename V >
+class ParallelFix : private boost::noncopyable {
+
+public: // types
+
+    typedef boost::shared_ptr< ParallelFix<K,V> > Ptr;
+
+    class Self;
+
+    typedef boost::function< V ( const Self&, K ) >   open_type;
+
+private: // types
+
+    /// Result of a call spawned on the pool
+    struct Slot
+    {
+        Slot() : pending(1) {}
+
+        V                    value;
+        boost::exception_ptr error;
+        boost::atomic<int>   pending;
+    };
+
+public: // types
+
+    /// A spawned call, to be given to join
+    class Spawned
+    {
+        friend class Self;
+
+        boost::shared_ptr<Slot>  slot_;    ///< set if the call went to the pool
+        V                        value_;   ///< else its result
+    };
+
+    /// Recursion given to f
+    class Self
+    {
+        friend class ParallelFix<K,V>;
+
+        ParallelFix<K,V>& fix_;
+
+        explicit Self( ParallelFix<K,V>& fix ) : fix_(fix) {}
+
+    public:
+
+        /// Calls the fixpoint on this thread
+        V operator()( K k ) const { return fix_(k); }
+
+        /// Starts a call, on the pool above the cutoff, else evaluated right away
+        Spawned spawn( K k ) const
+        {
+            Spawned s;
+            if( fix_.cutoff_ < k )
+            {
+                s.slot_.reset( new Slot() );
+                fix_.pool_.push( boost::bind( &ParallelFix<K,V>::spawned, &fix_, s.slot_, k ) );
+            }
+            else
+                s.value_ = fix_(k);
+            return s;
+        }
+
+        /// Waits for a spawned call, running pool tasks meanwhile
+        /// @returns its result, or rethrows its exception
+        V join( const Spawned& s ) const
+        {
+            if( !s.slot_ )
+                return s.value_;
+
+            fix_.pool_.help_until( s.slot_->pending );
+            if( s.slot_->error )
+                boost::rethrow_exception( s.slot_->error );
+            return s.slot_->value;
+        }
+    };
+
+private: // data
+
+    open_type        f_;
+    K                cutoff_;    ///< arguments up to it are evaluated serially
+    StealingPool&    pool_;
+
+    Self             self_;
+
+public: // methods
+
+    ParallelFix( open_type f, K cutoff, StealingPool& pool ) :
+        f_(f),
+        cutoff_(cutoff),
+        pool_(pool),
+        self_(*this)
+    {}
+
+    V operator()( K k ) { return f_( self_, k ); }
+
+    /// Factory method
+    static Ptr create( open_type f, K cutoff, StealingPool& pool )
+    {
+        return Ptr( new ParallelFix<K,V>( f, cutoff, pool ) );
+    }
+
+private: // methods
+
+    void spawned( boost::shared_ptr<Slot> slot, K k )
+    {
+        try
+        {
+            slot->value = (*this)(k);
+        }
+        catch( ... )
+        {
+            slot->error = boost::current_exception();
+        }
+        slot->pending.fetch_sub( 1, boost::memory_order_release );
+    }
+
+};
+
+/// Parallel Y-combinator
+/// f recurses through the Self of ParallelFix, spawning and joining its calls
+/// @returns the fixpoint of f, with calls spawned above cutoff evaluated in parallel on pool
+template < typename K, typename V >
+boost::function< V ( K ) > ycomb_parallel( typename ParallelFix<K,V>::open_type f,
+                                           K cutoff,
+                                           StealingPool& pool )
+{
+    typename ParallelFix<K,V>::Ptr p = ParallelFix<K,V>::create( f, cutoff, pool );
+    return boost::bind( &ParallelFix<K,V>::operator(), p, _1 );
+}
+
+//-----------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,122 @@
+/**
+ * Fixpoint combinator without type erasure
+ *
+ * fib through ycomb, through fix, and as a plain recursive function
+ * The argument is read at run time, FIB by default, so the compiler cannot fold the work
+ *
+ **/
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <boost/bind.hpp>
+#include <boost/chrono.hpp>
+#include <boost/function.hpp>
+
+#include "Fix.h"
+
+//-----------------------------------------------------------------------------
+
+#define HERE  std::cout << "--" << __LINE__ << std::endl;
+
+//-----------------------------------------------------------------------------
+
+#define FIB  32   ///< default argument
+
+//-----------------------------------------------------------------------------
+
+typedef boost::function<int(int)> int_2_int_f;
+
+// Y-combinator compatible fibonacci
+int fib( int_2_int_f f, int v )
+{
+    if( v < 2 ) return v;
+    return f(v-1) + f(v-2);
+}
+
+// Y-combinator for the int type
+int_2_int_f ycomb ( boost::function< int ( int_2_int_f, int ) > f )
+{
+  return boost::bind( f, boost::bind( &ycomb, f ), _1);
+}
+
+//-----------------------------------------------------------------------------
+
+// fix compatible fibonacci, self is any callable
+struct Fib {
+
+    typedef int result_type;
+
+    template < typename Self >
+    int operator()( const Self& f, int v ) const
+    {
+        if( v < 2 ) return v;
+        return f(v-1) + f(v-2);
+    }
+};
+
+// fix compatible Ackermann function, two arguments
+struct Ackermann {
+
+    typedef unsigned long result_type;
+
+    template < typename Self >
+    unsigned long operator()( const Self& f, unsigned long m, unsigned long n ) const
+    {
+        if( m == 0 ) return n + 1;
+        if( n == 0 ) return f( m - 1, 1ul );
+        return f( m - 1, f( m, n - 1 ) );
+    }
+};
+
+// fix compatible string repetition, other types
+struct Repeat {
+
+    typedef std::string result_type;
+
+    template < typename Self >
+    std::string operator()( const Self& f, const std::string& s, int n ) const
+    {
+        return n == 0 ? std::string() : s + f( s, n - 1 );
+    }
+};
+
+// plain recursion
+int fib_direct( int v )
+{
+    if( v < 2 ) return v;
+    return fib_direct(v-1) + fib_direct(v-2);
+}
+
+//-----------------------------------------------------------------------------
+
+typedef boost::chrono::steady_clock clock_type;
+
+template < typename F >
+int bench( const std::string& what, F f, int v )
+{
+    clock_type::time_point start = clock_type::now();
+    int r = f(v);
+    boost::chrono::duration<double> elapsed = clock_type::now() - start;
+    std::cout << "> " << what << " fib(" << v << ") = " << r << " in " << elapsed.count() << " s" << std::endl;
+    return r;
+}
+
+int main( int argc, char* argv[] )
+{
+    std::cout << "> starting main" << std::endl;
+
+    int n = argc > 1 ? std::atoi( argv[1] ) : FIB;
+
+    int r1 = bench( "ycomb ", ycomb( fib ), n );
+    int r2 = bench( "fix   ", fix( Fib() ), n );
+    int r3 = bench( "direct", &fib_direct, n );
+
+    std::cout << "> results " << ( r1 == r2 && r2 == r3 ? "match" : "DIFFER" ) << std::endl;
+
+    std::cout << "> ackermann(2,3) = " << fix( Ackermann() )( 2ul, 3ul ) << std::endl;
+    std::cout << "> repeat(ab,3) = " << fix( Repeat() )( std::string("ab"), 3 ) << std::endl;
+
+    std::cout << "> ending main" << std::endl;
+}
@@ -0,0 +1,110 @@
+/**
+ * Memoizing Y-combinator
+ *
+ * The open recursive fib of boost_ycombinator, through ycomb and through ycomb_memo,
+ * which computes each argument once and is shared between threads
+ *
+ **/
+
+#define BOOST_THREAD_VERSION 3
+
+#include <iostream>
+
+#include <boost/bind.hpp>
+#include <boost/chrono.hpp>
+#include <boost/function.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "Memo.h"
+
+//-----------------------------------------------------------------------------
+
+#define HERE  std::cout << "--" << __LINE__ << std::endl;
+
+//-----------------------------------------------------------------------------
+
+#define FIB_PLAIN   30
+#define FIB_MEMO    45
+#define N_THREADS    8
+#define MAX_SIZE    32
+
+//-----------------------------------------------------------------------------
+
+typedef boost::function<int(int)> int_2_int_f;
+
+static size_t nb_calls = 0; ///< calls into fib, from the main thread only
+
+// Y-combinator compatible fibonacci
+int fib( int_2_int_f f, int v )
+{
+    ++nb_calls;
+    if( v == 0 ) return 0;
+    if( v == 1 ) return 1;
+    return f(v-1) + f(v-2);
+}
+
+int fib_mt( int_2_int_f f, int v )
+{
+    if( v < 2 ) return v;
+    return f(v-1) + f(v-2);
+}
+
+// Y-combinator for the int type
+int_2_int_f ycomb ( boost::function< int ( int_2_int_f, int ) > f )
+{
+  return boost::bind( f, boost::bind( &ycomb, f ), _1);
+}
+
+//-----------------------------------------------------------------------------
+
+typedef boost::chrono::steady_clock clock_type;
+
+double since( clock_type::time_point start )
+{
+    return boost::chrono::duration<double>( clock_type::now() - start ).count();
+}
+
+void compute( int_2_int_f f, int v, int* r ) { *r = f(v); }
+
+int main()
+{
+    std::cout << "> starting main" << std::endl;
+
+    // plain ycomb, exponential nb of calls
+
+    clock_type::time_point start = clock_type::now();
+    int r = ycomb( fib )( FIB_PLAIN );
+    std::cout << "> ycomb      fib(" << FIB_PLAIN << ") = " << r << " with " << nb_calls << " calls in " << since(start) << " s" << std::endl;
+
+    // memoized, each argument computed once
+
+    nb_calls = 0;
+    Memoized<int,int>::Ptr memo = Memoized<int,int>::create( fib );
+
+    start = clock_type::now();
+    r = (*memo)( FIB_MEMO );
+    std::cout << "> ycomb_memo fib(" << FIB_MEMO << ") = " << r << " with " << nb_calls << " calls in " << since(start) << " s"
+              << ", " << memo->table().size() << " entries" << std::endl;
+
+    // bounded table, still linear since only recent entries are needed
+
+    int_2_int_f bounded = ycomb_memo<int,int>( fib, MAX_SIZE );
+    nb_calls = 0;
+    r = bounded( FIB_MEMO );
+    std::cout << "> bounded to " << MAX_SIZE << " entries, fib(" << FIB_MEMO << ") = " << r << " with " << nb_calls << " calls" << std::endl;
+
+    // one table shared by several threads, each key computed by a single thread
+
+    int_2_int_f shared = ycomb_memo<int,int>( fib_mt );
+
+    std::vector<int> results( N_THREADS );
+    boost::thread_group threads;
+    for( int i = 0; i < N_THREADS; ++i )
+        threads.create_thread( boost::bind( &compute, shared, FIB_MEMO - i, &results[i] ) );
+    threads.join_all();
+
+    for( int i = 0; i < N_THREADS; ++i )
+        std::cout << "> thread " << i << " fib(" << FIB_MEMO - i << ") = " << results[i] << std::endl;
+
+    std::cout << "> ending main" << std::endl;
+}
@@ -0,0 +1,141 @@
+/**
+ * Parallel Y-combinator
+ *
+ * The open recursive fib of boost_ycombinator, forking one recursive call and
+ * joining it: calls spawned above a cutoff become tasks on a work stealing pool,
+ * timed against ycomb and the same fixpoint kept serial by a cutoff above the
+ * argument. Hofstadter's Q sequence, whose calls take their arguments from earlier
+ * results, joins those first and still forks the independent ones.
+ *
+ **/
+
+#define BOOST_THREAD_VERSION 3
+
+#include <iostream>
+
+#include <boost/bind.hpp>
+#include <boost/chrono.hpp>
+#include <boost/function.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "Parallel.h"
+
+//-----------------------------------------------------------------------------
+
+#define HERE  std::cout << "--" << __LINE__ << std::endl;
+
+//-----------------------------------------------------------------------------
+
+#define FIB        32
+#define CUTOFF     20
+#define Q          30
+#define Q_CUTOFF   18
+#define N_THREADS   4
+
+//-----------------------------------------------------------------------------
+
+typedef boost::function<int(int)> int_2_int_f;
+
+// Y-combinator compatible fibonacci
+int fib( int_2_int_f f, int v )
+{
+    if( v == 0 ) return 0;
+    if( v == 1 ) return 1;
+    if( v == 2 ) return 1; // optional -- better performance
+    if( v == 3 ) return 2; // optional -- better performance
+    return f(v-1) + f(v-2);
+}
+
+// Y-combinator for the int type
+int_2_int_f ycomb ( boost::function< int ( int_2_int_f, int ) > f )
+{
+  return boost::bind( f, boost::bind( &ycomb, f ), _1);
+}
+
+// Y-combinator compatible Hofstadter Q sequence
+int hofstadter( int_2_int_f f, int n )
+{
+    if( n <= 2 ) return 1;
+    return f( n - f(n-1) ) + f( n - f(n-2) );
+}
+
+//-----------------------------------------------------------------------------
+
+typedef ParallelFix<int,int>::Self self_type;
+
+// the same fibonacci, forking the first recursive call
+int pfib( const self_type& self, int v )
+{
+    if( v == 0 ) return 0;
+    if( v == 1 ) return 1;
+    if( v == 2 ) return 1;
+    if( v == 3 ) return 2;
+    ParallelFix<int,int>::Spawned a = self.spawn(v-1);
+    int b = self(v-2);
+    return self.join(a) + b;
+}
+
+// the same Q sequence: the outer calls need the inner results, so each pair is joined first
+int phofstadter( const self_type& self, int n )
+{
+    if( n <= 2 ) return 1;
+    ParallelFix<int,int>::Spawned a = self.spawn(n-1);
+    int q2 = self(n-2);
+    int q1 = self.join(a);
+    ParallelFix<int,int>::Spawned b = self.spawn( n - q1 );
+    int r2 = self( n - q2 );
+    return self.join(b) + r2;
+}
+
+//-----------------------------------------------------------------------------
+
+typedef boost::chrono::steady_clock clock_type;
+
+double since( clock_type::time_point start )
+{
+    return boost::chrono::duration<double>( clock_type::now() - start ).count();
+}
+
+int main()
+{
+    std::cout << "> starting main" << std::endl;
+
+    clock_type::time_point start = clock_type::now();
+    int r1 = ycomb( fib )( FIB );
+    std::cout << "> ycomb          fib(" << FIB << ") = " << r1 << " in " << since(start) << " s" << std::endl;
+
+    StealingPool pool( N_THREADS );
+
+    // baseline through the same ParallelFix, with a cutoff keeping it all serial
+
+    int_2_int_f sfib = ycomb_parallel<int,int>( pfib, FIB, pool );
+
+    start = clock_type::now();
+    int r2 = sfib( FIB );
+    double serial = since(start);
+    std::cout << "> serial         fib(" << FIB << ") = " << r2 << " in " << serial << " s" << std::endl;
+
+    int_2_int_f par = ycomb_parallel<int,int>( pfib, CUTOFF, pool );
+
+    start = clock_type::now();
+    int r3 = par( FIB );
+    double parallel = since(start);
+    std::cout << "> ycomb_parallel fib(" << FIB << ") = " << r3 << " in " << parallel << " s"
+              << " on " << pool.size() << " threads, serial below " << CUTOFF << std::endl;
+
+    std::cout << "> speedup " << serial / parallel << " over serial, on "
+              << boost::thread::hardware_concurrency() << " cores" << std::endl;
+
+    std::cout << "> results " << ( r1 == r2 && r2 == r3 ? "match" : "DIFFER" ) << std::endl;
+
+    start = clock_type::now();
+    int q1 = ycomb( hofstadter )( Q );
+    std::cout << "> ycomb          Q(" << Q << ") = " << q1 << " in " << since(start) << " s" << std::endl;
+
+    start = clock_type::now();
+    int q2 = ycomb_parallel<int,int>( phofstadter, Q_CUTOFF, pool )( Q );
+    std::cout << "> ycomb_parallel Q(" << Q << ") = " << q2 << " in " << since(start) << " s"
+              << ", results " << ( q1 == q2 ? "match" : "DIFFER" ) << std::endl;
+
+    std::cout << "> ending main" << std::endl;
+}
@@ -0,0 +1,100 @@
+#ifndef Active_h
+#define Active_h
+
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include "message_queue.h"
+
+//-----------------------------------------------------------------------------
+
+/// Active object with a single worker thread
+/// Suitable for wrapping around resources that need synchronized access
+
+typedef std::function<void()> Message;
+
+class Active {
+
+private: // methods
+
+    Active(const Active&) = delete;
+    Active& operator=(const Active&) = delete;
+
+    /// Constructor
+    /// Starts up everything, using run as the thread mainline
+    Active();
+
+    /// Flags the
+    void finish(){ done_ = true; }
+    void run();
+
+private: // data
+
+    message_queue<Message>      mq_;        ///< message queue
+    bool                       done_;      ///< flag for finishing
+    std::thread              thd_;       ///< thread object
+
+public: // methods
+
+    /// Destructor
+    /// Enqueue done message and wait for queue to drain
+    virtual ~Active();
+
+    /// Enqueue a message
+    void send( Message msg );
+
+    /// Factory -- construction & thread start
+    static std::unique_ptr<Active> create();
+
+};
+
+//-----------------------------------------------------------------------------
+
+inline Active::Active(): done_(false)
+{
+}
+
+inline Active::~Active()
+{
+  Message finish_msg = std::bind( &Active::finish, this );
+  // enqueue finish message
+  send(finish_msg);
+  // wait for all processing in queue
+  thd_.join();
+}
+
+//-----------------------------------------------------------------------------
+
+inline void Active::send( Message msg )
+{
+    mq_.push(msg);
+}
+
+//-----------------------------------------------------------------------------
+
+inline void Active::run()
+{
+  std::cout << "> starting run()" << std::endl;
+  while (!done_)
+  {
+    Message f;
+    mq_.wait_and_pop(f);
+    f();
+  }
+  std::cout << "> ending run()" << std::endl;
+}
+
+//-----------------------------------------------------------------------------
+
+inline std::unique_ptr<Active> Active::create()
+{
+    std::unique_ptr<Active> pao( new Active() );
+    pao->thd_ = std::thread(&Active::run, pao.get());
+    return pao;
+}
+
+//-----------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef Continuator_h
+#define Continuator_h
+
+#include <chrono>
+#include <functional>
+#include <memory>
+
+#include "TimerService.h"
+
+//-----------------------------------------------------------------------------
+
+/// The continuation monad according to Bartosz Milewski
+/// http://fpcomplete.com/asynchronous-api-in-c-and-the-continuation-monad/
+///
+/// A Continuator produces an A, possibly later and on another thread, and hands it
+/// to the continuation given to andThen. Return and Bind are the monad's unit and bind.
+
+template< typename R, typename A >
+struct Continuator {
+    virtual ~Continuator() {}
+    virtual R andThen( std::function< R (A) > k ) = 0;
+};
+
+//-----------------------------------------------------------------------------
+
+/// Produces x right away
+template< typename R, typename A >
+struct Return : Continuator<R,A> {
+    Return(A x) : _x(x) {}
+    R andThen( std::function<R(A)> k) {
+        return k(_x);
+    }
+    A _x;
+};
+
+//-----------------------------------------------------------------------------
+
+/// Runs ktor, then the Continuator built by rest from its value
+template< typename R, typename A, typename C>
+struct Bind : Continuator<R,A>
+{
+    Bind( C ktor, std::function< std::unique_ptr< Continuator<R,A> > ( A ) > rest ) :
+        ktor_(ktor),
+        rest_(rest)
+    {}
+
+    void andThen( std::function<R(A)> k )
+    {
+        std::function< std::unique_ptr< Continuator<R,A> > ( A ) > rest = rest_;
+        std::function<R(A)> lambda = [k, rest](A a)
+        {
+            return rest(a)->andThen(k);
+        };
+        ktor_.andThen(lambda);
+    }
+
+    C ktor_;
+    std::function< std::unique_ptr< Continuator<R,A> > ( A ) > rest_;
+};
+
+//-----------------------------------------------------------------------------
+
+/// Produces a value after a delay in ms, holding no thread meanwhile
+template< typename A >
+struct Delayed : Continuator<void, A>
+{
+    Delayed( A x, int ms ) : x_(x), ms_(ms) {}
+
+    void andThen( std::function<void(A)> k )
+    {
+        A x = x_;
+        TimerService::instance().after( std::chrono::milliseconds(ms_), [k, x]() { k(x); } );
+    }
+    A   x_;
+    int ms_;
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef Executor_h
+#define Executor_h
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+
+/// Fixed pool of threads running posted tasks
+///
+/// Asynchronous operations and their continuations are posted here instead of
+/// each starting its own thread, so the nb of threads stays bounded however
+/// many continuation chains are in flight.
+/// The submission queue is bounded: posting blocks while it is full, except from
+/// the pool's own threads, which could otherwise all block and never drain it.
+
+class Executor {
+
+public: // types
+
+    typedef std::function< void () > Task;
+
+private: // data
+
+    mutable std::mutex         m_;
+    std::condition_variable    not_empty_;
+    std::condition_variable    not_full_;
+
+    std::deque<Task>           queue_;     ///< submitted tasks
+    size_t                     max_;       ///< max queued tasks, 0 is unlimited
+    bool                       done_;      ///< flag for finishing
+
+    std::vector<std::thread>   threads_;   ///< worker threads
+
+    Executor( const Executor& ) = delete;
+    Executor& operator=( const Executor& ) = delete;
+
+public: // methods
+
+    /// Constructor
+    /// Starts the worker threads
+    Executor( size_t nb_threads = std::thread::hardware_concurrency(), size_t max_queue = 0 ) :
+        max_(max_queue),
+        done_(false)
+    {
+        if( !nb_threads )
+            nb_threads = 1;
+        for( size_t i = 0; i < nb_threads; ++i )
+            threads_.push_back( std::thread( &Executor::run, this ) );
+    }
+
+    /// Destructor
+    /// Runs the tasks still queued, including those they post, then joins the threads
+    ~Executor()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_);
+            done_ = true;
+        }
+        not_empty_.notify_all();
+        not_full_.notify_all();
+
+        for( size_t i = 0; i < threads_.size(); ++i )
+            threads_[i].join();
+    }
+
+    /// Queues a task, blocks while the queue is full unless called from the pool itself
+    void post( Task t )
+    {
+        std::unique_lock<std::mutex> lock(m_);
+
+        if( current() != this )
+            while( max_ && queue_.size() >= max_ && !done_ )
+                not_full_.wait(lock);
+
+        queue_.push_back( std::move(t) );
+        not_empty_.notify_one();
+    }
+
+    /// @returns the nb of tasks waiting to run
+    size_t qsize() const
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        return queue_.size();
+    }
+
+    /// @returns the nb of worker threads
+    size_t tsize() const { return threads_.size(); }
+
+    /// @returns the executor shared by default, with one thread per core
+    static Executor& instance()
+    {
+        static Executor e;
+        return e;
+    }
+
+private: // methods
+
+    /// @returns the executor running the calling thread, if any
+    static Executor*& current()
+    {
+        static thread_local Executor* e = 0;
+        return e;
+    }
+
+    void run()
+    {
+        current() = this;
+
+        while( true )
+        {
+            Task t;
+            {
+                std::unique_lock<std::mutex> lock(m_);
+                while( queue_.empty() && !done_ )
+                    not_empty_.wait(lock);
+                if( queue_.empty() ) // done and drained
+                    return;
+                t = std::move( queue_.front() );
+                queue_.pop_front();
+                not_full_.notify_one();
+            }
+            t();
+        }
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
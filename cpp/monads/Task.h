@@ -0,0 +1,325 @@
+#ifndef Task_h
+#define Task_h
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <future>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "Executor.h"
+
+//-----------------------------------------------------------------------------
+
+/// Coroutine tasks, so continuation chains are written as straight-line code
+///
+/// A Task is lazy: it starts when awaited. If it finishes before its awaiter suspends,
+/// the awaiter just carries on, so chains of tasks completing synchronously do not
+/// build up the stack, whether or not the compiler turns resumes into tail calls.
+/// If it finishes later, it transfers control straight to its awaiter (symmetric transfer).
+/// The coroutine frame is the only allocation.
+/// Each task may have an Executor: awaited async operations resume it there, instead of
+/// on whatever thread completed them. Awaited tasks inherit the executor of their awaiter.
+
+template< typename T >
+class Task;
+
+namespace detail {
+
+struct TaskPromiseBase
+{
+    struct final_awaiter
+    {
+        bool await_ready() noexcept { return false; }
+
+        template< typename P >
+        std::coroutine_handle<> await_suspend( std::coroutine_handle<P> h ) noexcept
+        {
+            TaskPromiseBase& p = h.promise();
+            if( p.ready_.exchange( true, std::memory_order_acq_rel ) && p.continuation_ ) // awaiter is suspended
+                return p.continuation_;
+            return std::noop_coroutine();
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    final_awaiter       final_suspend() noexcept   { return {}; }
+
+    void unhandled_exception() { error_ = std::current_exception(); }
+
+    Executor* executor() const { return exec_; }
+
+    std::coroutine_handle<>  continuation_;   ///< awaiter to resume when done
+    std::exception_ptr       error_;
+    Executor*                exec_ = 0;       ///< where async operations resume this task, if set
+    std::atomic<bool>        ready_{ false };  ///< set by the first of task end and awaiter suspension
+};
+
+template< typename T >
+struct TaskPromise : TaskPromiseBase
+{
+    Task<T> get_return_object();
+
+    template< typename U >
+    void return_value( U&& v ) { value_.emplace( std::forward<U>(v) ); }
+
+    T result()
+    {
+        if( error_ )
+            std::rethrow_exception( error_ );
+        return std::move( *value_ );
+    }
+
+    std::optional<T> value_;
+};
+
+template<>
+struct TaskPromise<void> : TaskPromiseBase
+{
+    Task<void> get_return_object();
+
+    void return_void() {}
+
+    void result()
+    {
+        if( error_ )
+            std::rethrow_exception( error_ );
+    }
+};
+
+/// Starts an awaited task, transferring control to it
+template< typename T >
+struct TaskAwaiter
+{
+    std::coroutine_handle< TaskPromise<T> > h;
+
+    bool await_ready() noexcept { return false; }
+
+    /// Runs the task until it finishes or suspends
+    /// @returns false, not suspending the awaiter, if the task has finished already
+    template< typename P >
+    bool await_suspend( std::coroutine_handle<P> awaiting )
+    {
+        h.promise().continuation_ = awaiting;
+        if( !h.promise().exec_ )
+            h.promise().exec_ = awaiting.promise().executor();
+        h.resume();
+        return !h.promise().ready_.exchange( true, std::memory_order_acq_rel );
+    }
+
+    T await_resume() { return h.promise().result(); }
+};
+
+/// Moves the awaiting task onto an executor
+struct ResumeOn
+{
+    Executor& e;
+
+    bool await_ready() noexcept { return false; }
+
+    template< typename P >
+    void await_suspend( std::coroutine_handle<P> h )
+    {
+        h.promise().exec_ = &e;
+        e.post( [h]() { h.resume(); } );
+    }
+
+    void await_resume() noexcept {}
+};
+
+/// Resumes a suspended coroutine on its executor, or inline if it has none
+inline void resume( std::coroutine_handle<> h, Executor* e )
+{
+    if( e )
+        e->post( [h]() { h.resume(); } );
+    else
+        h.resume();
+}
+
+}
+
+//-----------------------------------------------------------------------------
+
+template< typename T >
+class Task {
+
+public: // types
+
+    typedef detail::TaskPromise<T>               promise_type;
+    typedef std::coroutine_handle<promise_type>  handle_type;
+
+private: // data
+
+    handle_type h_;
+
+public: // methods
+
+    explicit Task( handle_type h ) : h_(h) {}
+
+    Task( Task&& o ) noexcept : h_( std::exchange( o.h_, {} ) ) {}
+
+    Task( const Task& ) = delete;
+    Task& operator=( const Task& ) = delete;
+
+    ~Task()
+    {
+        if( h_ )
+            h_.destroy();
+    }
+
+    /// Sets the executor the task resumes on
+    Task&& via( Executor& e ) &&
+    {
+        h_.promise().exec_ = &e;
+        return std::move(*this);
+    }
+
+    /// Awaiting a task starts it, the awaiter is resumed when it finishes
+    detail::TaskAwaiter<T> operator co_await() && noexcept { return detail::TaskAwaiter<T>{ h_ }; }
+
+};
+
+namespace detail {
+
+template< typename T >
+Task<T> TaskPromise<T>::get_return_object() { return Task<T>( Task<T>::handle_type::from_promise(*this) ); }
+
+inline Task<void> TaskPromise<void>::get_return_object() { return Task<void>( Task<void>::handle_type::from_promise(*this) ); }
+
+/// Coroutine that runs eagerly and frees itself, to drive a Task from plain code
+struct Detached
+{
+    struct promise_type
+    {
+        Detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+
+        Executor* executor() const { return 0; }
+    };
+};
+
+template< typename T >
+Detached complete( Task<T> t, std::promise<T>& p )
+{
+    try
+    {
+        if constexpr ( std::is_void<T>::value )
+        {
+            co_await std::move(t);
+            p.set_value();
+        }
+        else
+            p.set_value( co_await std::move(t) );
+    }
+    catch( ... )
+    {
+        p.set_exception( std::current_exception() );
+    }
+}
+
+}
+
+/// Runs a task, blocking the calling thread until it finishes
+/// @returns its value, or throws its exception
+template< typename T >
+T sync_wait( Task<T> t )
+{
+    std::promise<T> p;
+    std::future<T> f = p.get_future();
+    detail::complete( std::move(t), p );
+    return f.get();
+}
+
+//-----------------------------------------------------------------------------
+
+/// Awaitable moving the awaiting task onto an executor, which it then keeps
+inline detail::ResumeOn resume_on( Executor& e ) { return detail::ResumeOn{ e }; }
+
+//-----------------------------------------------------------------------------
+
+/// Awaitable for the value a callback-based operation passes to its continuation
+///
+/// start( k ) begins the operation, which eventually calls k( value ) on any thread.
+/// If k runs before start returns the task just carries on, otherwise k resumes it,
+/// on its executor if it has one: an atomic exchange decides which of the two it is.
+template< typename A, typename Start >
+class CallbackAwaiter {
+
+    enum { STARTING, SUSPENDED, COMPLETED };
+
+    Start               start_;
+    std::optional<A>    value_;
+    std::atomic<int>    state_;
+    Executor*           exec_;
+
+public: // methods
+
+    CallbackAwaiter( Start s ) : start_( std::move(s) ), state_( STARTING ), exec_(0) {}
+
+    bool await_ready() noexcept { return false; }
+
+    template< typename P >
+    bool await_suspend( std::coroutine_handle<P> h )
+    {
+        exec_ = h.promise().executor();
+
+        std::coroutine_handle<> c = h;
+        start_( [this, c]( A a )
+        {
+            value_.emplace( std::move(a) );
+            if( state_.exchange( COMPLETED, std::memory_order_acq_rel ) == SUSPENDED )
+                detail::resume( c, exec_ );
+        });
+
+        // stay suspended unless the operation has completed already
+        return state_.exchange( SUSPENDED, std::memory_order_acq_rel ) != COMPLETED;
+    }
+
+    A await_resume() { return std::move( *value_ ); }
+
+};
+
+/// @returns an awaitable for the value continuator c produces
+/// c is anything with andThen( std::function<void(A)> ), such as a Continuator<void,A>
+template< typename A, typename C >
+auto awaiting( C& c )
+{
+    auto start = [&c]( std::function<void(A)> k ) { c.andThen( std::move(k) ); };
+    return CallbackAwaiter< A, decltype(start) >( start );
+}
+
+/// @returns an awaitable for the result of f executed by an Active object
+/// ao is anything with send( std::function<void()> ), such as the Active of cpp/aop, f runs on its worker threads
+template< typename AO, typename F >
+auto call_on( AO& ao, F f )
+{
+    typedef typename std::invoke_result<F>::type R;
+    typedef typename std::conditional< std::is_void<R>::value, bool, R >::type value_type;
+
+    auto start = [&ao, f]( std::function<void(value_type)> k )
+    {
+        ao.send( [f, k]() mutable
+        {
+            if constexpr ( std::is_void<R>::value )
+            {
+                f();
+                k( true );
+            }
+            else
+                k( f() );
+        });
+    };
+    return CallbackAwaiter< value_type, decltype(start) >( start );
+}
+
+//-----------------------------------------------------------------------------
+
+#endif
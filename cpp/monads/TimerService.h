@@ -0,0 +1,202 @@
+#ifndef TimerService_h
+#define TimerService_h
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "Executor.h"
+
+//-----------------------------------------------------------------------------
+
+/// Runs callbacks at points in time, with a single thread for all pending timers
+///
+/// Pending timers sit in a min-heap ordered by deadline, the thread sleeps until the
+/// earliest one. A pending timer costs a heap entry, not a thread, so tens of thousands
+/// of waiting continuation chains need no more than this one thread.
+/// Expired callbacks run on the timer thread, or are posted to an Executor if given one,
+/// so long callbacks do not delay the other timers.
+
+class TimerService {
+
+public: // types
+
+    typedef std::chrono::steady_clock   clock_type;
+    typedef clock_type::time_point      time_point;
+    typedef clock_type::duration        duration;
+
+    typedef std::function< void () >    Task;
+
+    typedef unsigned long long          TimerId;
+
+private: // types
+
+    struct entry
+    {
+        time_point  deadline;
+        TimerId     id;         ///< increasing, so equal deadlines keep their order
+        Task        task;
+
+        bool operator> ( const entry& o ) const
+        {
+            return deadline > o.deadline || ( deadline == o.deadline && id > o.id );
+        }
+    };
+
+private: // data
+
+    mutable std::mutex         m_;
+    std::condition_variable    cond_;
+
+    std::priority_queue< entry, std::vector<entry>, std::greater<entry> > heap_;
+    std::unordered_set<TimerId> pending_;     ///< not yet fired nor cancelled
+    std::unordered_set<TimerId> cancelled_;   ///< still in the heap, skipped when they expire
+
+    TimerId                    next_;     ///< id of the next timer
+    bool                       done_;     ///< flag for finishing
+
+    Executor*                  exec_;     ///< runs the expired callbacks, if set
+
+    std::thread                thread_;   ///< the timer thread
+
+    TimerService( const TimerService& ) = delete;
+    TimerService& operator=( const TimerService& ) = delete;
+
+public: // methods
+
+    /// Constructor
+    /// @param exec runs the expired callbacks, if null they run on the timer thread
+    TimerService( Executor* exec = 0 ) :
+        next_(1),
+        done_(false),
+        exec_(exec)
+    {
+        thread_ = std::thread( &TimerService::run, this );
+    }
+
+    /// Destructor
+    /// Pending timers are discarded
+    ~TimerService()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_);
+            done_ = true;
+        }
+        cond_.notify_all();
+        thread_.join();
+    }
+
+    /// Runs the task at a point in time
+    /// @returns the id to cancel it
+    TimerId at( time_point t, Task task )
+    {
+        std::lock_guard<std::mutex> lock(m_);
+
+        entry e;
+        e.deadline = t;
+        e.id       = next_++;
+        e.task     = std::move(task);
+
+        bool earliest = heap_.empty() || t < heap_.top().deadline;
+
+        pending_.insert( e.id );
+        heap_.push( std::move(e) );
+
+        if( earliest ) // the thread sleeps until a later deadline
+            cond_.notify_one();
+
+        return next_ - 1;
+    }
+
+    /// Runs the task once the delay has passed
+    /// @returns the id to cancel it
+    TimerId after( duration d, Task task )
+    {
+        return at( clock_type::now() + d, std::move(task) );
+    }
+
+    /// Cancels a pending timer
+    /// @returns true if the timer was cancelled before firing
+    bool cancel( TimerId id )
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        if( !pending_.erase(id) )
+            return false;
+        cancelled_.insert(id);
+        return true;
+    }
+
+    /// @returns the nb of pending timers
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        return pending_.size();
+    }
+
+    /// @returns the timer service shared by default, posting callbacks to the shared Executor
+    static TimerService& instance()
+    {
+        static TimerService t( &Executor::instance() );
+        return t;
+    }
+
+private: // methods
+
+    void run()
+    {
+        std::vector<Task> due;
+
+        std::unique_lock<std::mutex> lock(m_);
+        while( !done_ )
+        {
+            if( heap_.empty() )
+            {
+                cond_.wait(lock);
+                continue;
+            }
+
+            time_point now = clock_type::now();
+            time_point next = heap_.top().deadline; // a copy, at() may reallocate the heap while we wait
+            if( next > now )
+            {
+                cond_.wait_until( lock, next );
+                continue;
+            }
+
+            // take everything due in one go
+
+            while( !heap_.empty() && heap_.top().deadline <= now )
+            {
+                entry e = heap_.top();
+                heap_.pop();
+                if( cancelled_.erase( e.id ) )
+                    continue;
+                pending_.erase( e.id );
+                due.push_back( std::move(e.task) );
+            }
+
+            lock.unlock(); // callbacks may schedule more timers
+
+            for( size_t i = 0; i < due.size(); ++i )
+            {
+                if( exec_ )
+                    exec_->post( std::move( due[i] ) );
+                else
+                    due[i]();
+            }
+            due.clear();
+
+            lock.lock();
+        }
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
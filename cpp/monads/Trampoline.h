@@ -0,0 +1,264 @@
+#ifndef Trampoline_h
+#define Trampoline_h
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+
+/// Runs continuation chains in a loop, in constant stack and without allocations
+///
+/// A chain is described by frames taken from a pool: bind pushes its rest on an explicit
+/// stack, a returned value pops and applies it. Nothing nests, a step is a function pointer
+/// call, and consumed frames go back to the pool, so after the first steps a chain neither
+/// grows the stack nor allocates. An asynchronous step suspends the loop, the completion
+/// resumes it on its own thread.
+///
+/// The steps of a chain may produce values of different types. Values travel through the
+/// frames as bytes, so they must be trivially copyable and fit in VALUE_SIZE bytes, anything
+/// bigger is passed by pointer.
+///
+/// Frames are recycled through a free list. Since a chain runs sequentially, and async
+/// hand-offs are ordered by an atomic, the pool needs no lock. One chain runs at a time.
+
+class Trampoline {
+
+public: // types
+
+    enum { VALUE_SIZE = 2 * sizeof(void*) };
+
+    struct Frame;
+
+    /// A step of a chain, producing an A
+    template< typename A >
+    struct Step
+    {
+        Frame* f;
+    };
+
+    typedef void (*start_fn)( Trampoline&, intptr_t env );     ///< starts an async step, must eventually call resume()
+
+    typedef std::aligned_storage< VALUE_SIZE >::type value_type;
+
+    /// Node of a chain description, owned by the pool
+    struct Frame
+    {
+        typedef void   (*erased_fn)();
+        typedef Frame* (*invoke_fn)( Trampoline&, erased_fn, const void* value, intptr_t env );
+
+        enum kind { RETURN, BIND, ASYNC };
+
+        kind        k;
+        value_type  value;   ///< RETURN
+        Frame*      ktor;    ///< BIND, runs first
+        erased_fn   rest;    ///< BIND, applied to the value of ktor
+        invoke_fn   invoke;  ///< BIND, calls rest with the value as its type
+        start_fn    start;   ///< ASYNC
+        intptr_t    env;     ///< captured state of rest or start
+        Frame*      next;    ///< free list link
+    };
+
+private: // types
+
+    struct rest
+    {
+        Frame::erased_fn  fn;
+        Frame::invoke_fn  invoke;
+        intptr_t          env;
+    };
+
+    enum { RUNNING, SUSPENDED, RESUMED };
+
+private: // data
+
+    Frame*             free_;       ///< pool of unused frames
+    size_t             allocated_;  ///< nb frames ever allocated
+
+    std::vector<rest>  stack_;      ///< pending rests of Binds
+    size_t             depth_;      ///< max size of the stack
+
+    Frame*             current_;    ///< frame to run next
+    std::function<void(const void*)> k_;   ///< final continuation
+
+    value_type         value_;      ///< value of the async step, set by resume
+    std::atomic<int>   sync_;       ///< who drives the loop after an async step
+
+    Trampoline( const Trampoline& ) = delete;
+    Trampoline& operator=( const Trampoline& ) = delete;
+
+public: // methods
+
+    Trampoline() : free_(0), allocated_(0), depth_(0), current_(0), sync_(RUNNING) { stack_.reserve(64); }
+
+    ~Trampoline()
+    {
+        while( free_ )
+        {
+            Frame* f = free_;
+            free_ = f->next;
+            delete f;
+        }
+    }
+
+    /// @returns a step producing a
+    template< typename A >
+    Step<A> ret( A a )
+    {
+        check<A>();
+        Frame* f = get( Frame::RETURN );
+        std::memcpy( &f->value, &a, sizeof(A) );
+        return Step<A>{ f };
+    }
+
+    /// @returns a step running m, then the step built by fn from its value
+    template< typename A, typename B >
+    Step<B> bind( Step<A> m, Step<B> (*fn)( Trampoline&, A, intptr_t ), intptr_t env = 0 )
+    {
+        Frame* f = get( Frame::BIND );
+        f->ktor   = m.f;
+        f->rest   = reinterpret_cast< Frame::erased_fn >( fn );
+        f->invoke = &Trampoline::invoke<A,B>;
+        f->env    = env;
+        return Step<B>{ f };
+    }
+
+    /// @returns a step that suspends the chain until start calls resume with an A
+    template< typename A >
+    Step<A> async( start_fn fn, intptr_t env = 0 )
+    {
+        check<A>();
+        Frame* f = get( Frame::ASYNC );
+        f->start = fn;
+        f->env   = env;
+        return Step<A>{ f };
+    }
+
+    /// Runs a chain, k gets its value
+    /// Returns when the chain completes or is suspended by an async step
+    template< typename A, typename K >
+    void run( Step<A> s, K k )
+    {
+        k_ = [k]( const void* v ) { k( *static_cast<const A*>(v) ); };
+        current_ = s.f;
+        loop();
+    }
+
+    /// Completes the pending async step, from any thread
+    /// A must be the type of the step, as given to async
+    template< typename A >
+    void resume( A a )
+    {
+        check<A>();
+        std::memcpy( &value_, &a, sizeof(A) );
+        if( sync_.exchange( RESUMED, std::memory_order_acq_rel ) == SUSPENDED ) // the starter has left the loop
+        {
+            current_ = resumed();
+            loop();
+        }
+    }
+
+    /// @returns the nb of frames ever allocated
+    size_t allocated() const { return allocated_; }
+
+    /// @returns the max depth of the stack of rests
+    size_t depth() const { return depth_; }
+
+private: // methods
+
+    template< typename A >
+    static void check()
+    {
+        static_assert( std::is_trivially_copyable<A>::value, "values must be trivially copyable" );
+        static_assert( sizeof(A) <= VALUE_SIZE, "values must fit in VALUE_SIZE bytes" );
+    }
+
+    /// Calls the rest of a bind with the value as the type it was bound with
+    template< typename A, typename B >
+    static Frame* invoke( Trampoline& t, Frame::erased_fn fn, const void* value, intptr_t env )
+    {
+        typedef Step<B> (*rest_fn)( Trampoline&, A, intptr_t );
+        return reinterpret_cast< rest_fn >( fn )( t, *static_cast<const A*>(value), env ).f;
+    }
+
+    Frame* get( Frame::kind k )
+    {
+        Frame* f = free_;
+        if( f )
+            free_ = f->next;
+        else
+        {
+            f = new Frame;
+            ++allocated_;
+        }
+        f->k = k;
+        return f;
+    }
+
+    void put( Frame* f )
+    {
+        f->next = free_;
+        free_ = f;
+    }
+
+    /// @returns a RETURN frame with the value given to resume
+    Frame* resumed()
+    {
+        Frame* f = get( Frame::RETURN );
+        f->value = value_;
+        return f;
+    }
+
+    void loop()
+    {
+        while( true )
+        {
+            Frame* f = current_;
+            switch( f->k )
+            {
+            case Frame::BIND:
+                stack_.push_back( rest{ f->rest, f->invoke, f->env } );
+                if( stack_.size() > depth_ )
+                    depth_ = stack_.size();
+                current_ = f->ktor;
+                put(f);
+                break;
+
+            case Frame::RETURN:
+            {
+                value_type v = f->value; // before the rest reuses the frame
+                put(f);
+                if( stack_.empty() )
+                    return k_( &v );
+                rest r = stack_.back();
+                stack_.pop_back();
+                current_ = r.invoke( *this, r.fn, &v, r.env );
+                break;
+            }
+
+            case Frame::ASYNC:
+            {
+                start_fn start = f->start;
+                intptr_t env   = f->env;
+                put(f);
+
+                sync_.store( RUNNING, std::memory_order_relaxed );
+                start( *this, env );
+                if( sync_.exchange( SUSPENDED, std::memory_order_acq_rel ) != RESUMED )
+                    return; // resume will drive the rest of the chain
+
+                current_ = resumed(); // resumed already, carry on here
+                break;
+            }
+            }
+        }
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,102 @@
+#define _GLIBCXX_USE_NANOSLEEP 1
+
+// The chains of continuation_monad_2 as coroutines
+//
+// co_await works on Continuators and on calls sent to the Active object of cpp/aop, so the
+// nested Bind<void,string,AsyncApi>(...) becomes a plain loop. Needs c++20.
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../aop/Active.h"
+
+#include "Continuator.h"
+#include "Task.h"
+
+using namespace std;
+
+//-----------------------------------------------------------------------------
+
+#define N_STEPS        3
+#define STEP_MS      100
+#define N_CALLS    10000
+#define N_NESTED 1000000
+
+//-----------------------------------------------------------------------------
+
+/// Makes every Continuator<void,A> awaitable
+template< typename A >
+auto operator co_await( Continuator<void,A>&& c ) { return awaiting<A>( c ); }
+
+template< typename A >
+auto operator co_await( Continuator<void,A>& c ) { return awaiting<A>( c ); }
+
+//-----------------------------------------------------------------------------
+
+/// LoopN of continuation_monad_2, without the Binds
+Task<string> loop_n( string s, int n )
+{
+    for( int i = 0; i < n; ++i )
+    {
+        cout << "[loop_n] " << s << " " << i << endl;
+        s = co_await Delayed<string>( "Done async", STEP_MS );
+    }
+    co_return "Done!";
+}
+
+/// Serialises updates to a counter through an Active object
+Task<long> count_on( Active& ao, int n )
+{
+    long counter = 0;
+    long last = 0;
+    for( int i = 0; i < n; ++i )
+        last = co_await call_on( ao, [&counter]() { return ++counter; } );
+    co_return last;
+}
+
+Task<long> add_one( long x ) { co_return x + 1; }
+
+/// A million nested tasks completing synchronously, symmetric transfer keeps the stack flat
+Task<long> nested( int n )
+{
+    long s = 0;
+    for( int i = 0; i < n; ++i )
+        s = co_await add_one( s );
+    co_return s;
+}
+
+//-----------------------------------------------------------------------------
+
+typedef chrono::steady_clock clock_type;
+
+int main()
+{
+    cout << "> starting main" << endl;
+
+    Executor& exec = Executor::instance();
+
+    clock_type::time_point start = clock_type::now();
+    string r = sync_wait( loop_n( "Begin ", N_STEPS ).via(exec) );
+    chrono::duration<double> elapsed = clock_type::now() - start;
+    cout << "> Finally " << r << " after " << elapsed.count() << " s" << endl;
+
+    std::unique_ptr<Active> ao = Active::create();
+    start = clock_type::now();
+    long c = sync_wait( count_on( *ao, N_CALLS ).via(exec) );
+    elapsed = clock_type::now() - start;
+    cout << "> " << c << " calls on the active object in " << elapsed.count() << " s, "
+         << long( N_CALLS / elapsed.count() ) << " calls/s" << endl;
+
+    start = clock_type::now();
+    long s = sync_wait( nested( N_NESTED ) );
+    elapsed = clock_type::now() - start;
+    cout << "> " << s << " nested tasks in " << elapsed.count() << " s, "
+         << long( N_NESTED / elapsed.count() ) << " tasks/s" << endl;
+
+    cout << "> ending main" << endl;
+}
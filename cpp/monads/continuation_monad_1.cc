@@ -7,21 +7,24 @@
 #include <string>
 #include <thread>
 #include <utility>
+#include <atomic>
+
+#include "Executor.h"
 
 using namespace std;
 
 
 //-----------------------------------------------------------------------------
 
-void asyncApi( function< void ( string )> handler )
+void asyncApi( function< void ( string )> handler, bool trace = true )
 {
-    thread th([handler]()
+    Executor::instance().post([handler,trace]()
     {
-        cout << "Started async\n";
+        if( trace )
+            cout << "Started async\n";
 //        std::this_thread::sleep_for(chrono::seconds(3));
         handler("Done async");
     });
-    th.detach();
 }
 
 //-----------------------------------------------------------------------------
@@ -36,10 +39,14 @@ struct Continuator {
 
 struct AsyncApi : Continuator<void, string >
 {
+    AsyncApi( bool trace = true ) : trace_(trace) {}
+
     void andThen( function< void( string ) > k )
     {
-        asyncApi(k);
+        asyncApi(k, trace_);
     }
+
+    bool trace_;
 };
 
 void print( string s )
@@ -47,8 +54,21 @@ void print( string s )
     cout << s << endl;
 }
 
+#define N_CALLS 100000
+
 int main()
 {
     AsyncApi callApi;
     callApi.andThen( print );
+
+    // many calls in flight, all on the executor's threads, without tracing
+
+    atomic<int> done(0);
+    for( int i = 0; i < N_CALLS; ++i )
+        AsyncApi(false).andThen( [&done]( string ) { ++done; } );
+
+    while( done < N_CALLS )
+        this_thread::yield();
+
+    cout << done << " calls completed on " << Executor::instance().tsize() << " threads" << endl;
 }
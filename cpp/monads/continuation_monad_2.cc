@@ -1,34 +1,29 @@
 #define _GLIBCXX_USE_NANOSLEEP 1
 
+#include <atomic>
 #include <functional>
+#include <future>
 #include <iostream>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
 #include <utility>
+#include <vector>
 
-using namespace std;
-
-//-----------------------------------------------------------------------------
+#include "Continuator.h"
 
-template< typename R, typename A >
-struct Continuator {
-    virtual ~Continuator() {}
-    virtual R andThen( function< R (A) > k ) {}
-};
+using namespace std;
 
 //-----------------------------------------------------------------------------
 
 void asyncApi( function< void ( string )> handler )
 {
-    thread th([handler]()
+    cout << "Started async\n";
+    TimerService::instance().after( chrono::seconds(3), [handler]()
     {
-        cout << "Started async\n";
-        std::this_thread::sleep_for(chrono::seconds(3));
         handler("Done async");
     });
-    th.detach();
 }
 
 struct AsyncApi : Continuator<void, string> {
@@ -40,41 +35,6 @@ struct AsyncApi : Continuator<void, string> {
 
 //-----------------------------------------------------------------------------
 
-template< typename R, typename A >
-struct Return : Continuator<R,A> {
-    Return(A x) : _x(x) {}
-    R andThen( function<R(A)> k) {
-        return k(_x);
-    }
-    A _x;
-};
-
-//-----------------------------------------------------------------------------
-
-template< typename R, typename A, typename C>
-struct Bind : Continuator<R,A>
-{
-    Bind( C ktor, function< unique_ptr< Continuator<R,A> > ( A ) > rest ) :
-        ktor_(ktor),
-        rest_(rest)
-    {}
-
-    void andThen( function<R(A)> k )
-    {
-        function< unique_ptr< Continuator<R,A> > ( A ) > rest = rest_;
-        function<R(A)> lambda = [k, rest](A a)
-        {
-            return rest(a)->andThen(k);
-        };
-        ktor_.andThen(lambda);
-    }
-
-    C ktor_;
-    function< unique_ptr< Continuator<R,A> > ( A ) > rest_;
-};
-
-//-----------------------------------------------------------------------------
-
 struct Loop : Continuator<void,string>
 {
     Loop( string s ) : s_(s) {}
@@ -117,64 +77,224 @@ struct LoopN : Continuator<void, string>
 
 //-----------------------------------------------------------------------------
 
-    struct And : Continuator<void, string>
+/// Completes with the values of both continuators, once the second one completes
+///
+/// The first completion stores its value, the second finds the countdown at zero and calls
+/// the continuation. The state is shared by both callbacks, not held by the And itself,
+/// so the And may go away while they are pending.
+template< typename A, typename B >
+struct And : Continuator<void, pair<A,B> >
+{
+    And( unique_ptr< Continuator<void,A> > ktor1, unique_ptr< Continuator<void,B> > ktor2 ) :
+        ktor1_( move(ktor1) ),
+        ktor2_( move(ktor2) )
+    {}
+
+    void andThen( function<void(pair<A,B>)> k )
+    {
+        shared_ptr<state> st( new state( move(ktor1_), move(ktor2_), k ) );
+
+        st->ktor1->andThen( [st]( A a ) { st->r.first  = move(a); st->done(); } );
+        st->ktor2->andThen( [st]( B b ) { st->r.second = move(b); st->done(); } );
+    }
+
+    struct state
+    {
+        state( unique_ptr< Continuator<void,A> > k1, unique_ptr< Continuator<void,B> > k2, function<void(pair<A,B>)> kk ) :
+            ktor1( move(k1) ), ktor2( move(k2) ), left( 2 ), k( kk ) {}
+
+        void done()
+        {
+            if( left.fetch_sub( 1, memory_order_acq_rel ) == 1 ) // release our value, acquire the other
+                k( move(r) );
+        }
+
+        unique_ptr< Continuator<void,A> > ktor1;   ///< kept alive until both complete
+        unique_ptr< Continuator<void,B> > ktor2;
+        pair<A,B>                         r;
+        atomic<int>                       left;    ///< nb not yet completed
+        function<void(pair<A,B>)>         k;
+    };
+
+    unique_ptr< Continuator<void,A> > ktor1_;
+    unique_ptr< Continuator<void,B> > ktor2_;
+};
+
+//-----------------------------------------------------------------------------
+
+/// Completes with the values of all continuators, in their order, once the last one completes
+///
+/// Each continuator writes its own preallocated slot and decrements an atomic countdown,
+/// the one reaching zero calls the continuation: one atomic operation per completion, no lock.
+template< typename A >
+struct WhenAll : Continuator<void, vector<A> >
+{
+    typedef unique_ptr< Continuator<void,A> > ktor_ptr;
+
+    WhenAll( vector< ktor_ptr > ktors ) : ktors_( move(ktors) ) {}
+
+    void andThen( function<void(vector<A>)> k )
     {
-        And(unique_ptr<Continuator<void,string> > & ktor1,
-            unique_ptr<Continuator<void,string> > & ktor2)
-            : _ktor1(move(ktor1)),
-              _ktor2(move(ktor2))
-        {}
+        shared_ptr<state> st( new state( move(ktors_), k ) );
+
+        if( st->ktors.empty() )
+            return k( vector<A>() );
 
-        void andThen(function<void(pair<string, string>)> k)
+        for( size_t i = 0; i < st->ktors.size(); ++i )
         {
-            _ktor1->andThen([this, k](string s1)
+            st->ktors[i]->andThen( [st, i]( A a )
             {
-                            lock_guard<mutex> l(_mtx);
-                    if (_s2.empty())
-                    _s1 = s1;
-            else
-            k(make_pair(s1, _s2));
-        });
-        _ktor2->andThen([this, k](string s2)
+                st->results[i] = move(a);
+                if( st->left.fetch_sub( 1, memory_order_acq_rel ) == 1 ) // release our slot, acquire all others
+                    st->k( move( st->results ) );
+            });
+        }
+    }
+
+    struct state
+    {
+        state( vector< ktor_ptr > ks, function<void(vector<A>)> kk ) :
+            ktors( move(ks) ), results( ktors.size() ), left( ktors.size() ), k( kk ) {}
+
+        vector< ktor_ptr >         ktors;    ///< kept alive until all complete
+        vector<A>                  results;  ///< one slot per continuator
+        atomic<size_t>             left;     ///< nb not yet completed
+        function<void(vector<A>)>  k;
+    };
+
+    vector< ktor_ptr > ktors_;
+};
+
+/// Completes with the index and value of the first continuator to complete
+///
+/// The first completion wins an atomic flag and calls the continuation, later ones are dropped.
+template< typename A >
+struct WhenAny : Continuator<void, pair<size_t,A> >
+{
+    typedef unique_ptr< Continuator<void,A> > ktor_ptr;
+
+    WhenAny( vector< ktor_ptr > ktors ) : ktors_( move(ktors) ) {}
+
+    void andThen( function<void(pair<size_t,A>)> k )
+    {
+        shared_ptr<state> st( new state( move(ktors_), k ) );
+
+        for( size_t i = 0; i < st->ktors.size(); ++i )
         {
-                        lock_guard<mutex> l(_mtx);
-        if (_s1.empty())
-        _s2 = s2;
-        else
-        k(make_pair(_s1, s2));
-    });
+            st->ktors[i]->andThen( [st, i]( A a )
+            {
+                if( !st->fired.exchange( true, memory_order_acq_rel ) )
+                    st->k( make_pair( i, move(a) ) );
+            });
+        }
     }
-    mutex _mtx;
-    string _s1;
-    string _s2;
-    unique_ptr< Continuator<void,string> > _ktor1;
-    unique_ptr< Continuator<void,string> > _ktor2;
+
+    struct state
+    {
+        state( vector< ktor_ptr > ks, function<void(pair<size_t,A>)> kk ) :
+            ktors( move(ks) ), fired( false ), k( kk ) {}
+
+        vector< ktor_ptr >              ktors;   ///< kept alive until all complete
+        atomic<bool>                    fired;   ///< set by the first completion
+        function<void(pair<size_t,A>)>  k;
     };
 
+    vector< ktor_ptr > ktors_;
+};
+
+//-----------------------------------------------------------------------------
+
+template< typename A >
+void collect( vector< unique_ptr< Continuator<void,A> > >& ) {}
+
+template< typename A, typename C, typename... Cs >
+void collect( vector< unique_ptr< Continuator<void,A> > >& v, C c, Cs... cs )
+{
+    v.push_back( move(c) );
+    collect( v, move(cs)... );
+}
+
+template< typename A >
+WhenAll<A> when_all( vector< unique_ptr< Continuator<void,A> > > ktors )
+{
+    return WhenAll<A>( move(ktors) );
+}
+
+template< typename A, typename... Cs >
+WhenAll<A> when_all( unique_ptr< Continuator<void,A> > c, Cs... cs )
+{
+    vector< unique_ptr< Continuator<void,A> > > v;
+    v.reserve( 1 + sizeof...(cs) );
+    collect( v, move(c), move(cs)... );
+    return WhenAll<A>( move(v) );
+}
+
+template< typename A >
+WhenAny<A> when_any( vector< unique_ptr< Continuator<void,A> > > ktors )
+{
+    return WhenAny<A>( move(ktors) );
+}
+
+template< typename A, typename... Cs >
+WhenAny<A> when_any( unique_ptr< Continuator<void,A> > c, Cs... cs )
+{
+    vector< unique_ptr< Continuator<void,A> > > v;
+    v.reserve( 1 + sizeof...(cs) );
+    collect( v, move(c), move(cs)... );
+    return WhenAny<A>( move(v) );
+}
+
 //-----------------------------------------------------------------------------
 
-//    void main()
-//    {
-//        LoopN("Begin ", 3).andThen([](string s)
-//        {
-//            cout << "Finally " << s << endl;
-//        });
-//        for(int i = 0; i < 15; ++i)
-//        {
-//            cout << i << endl;
-//            this_thread::sleep_for(chrono::seconds(1));
-//        }
-//    }
+#define N_FANOUT 500
+
+typedef unique_ptr< Continuator<void,string> > string_ktor;
 
 int main()
 {
-    And both (
-                (new LoopN("Begin 1 ", 3))->andThen([](string s) { cout << "Finally 1 " << s << endl; }),
-                (new LoopN("Begin 2 ", 4))->andThen([](string s) { cout << "Finally 2 " << s << endl; }) );
+    cout << "> starting main" << endl;
+
+    // two loops joined, and two delayed values raced
 
-    for(int i = 0; i < 15; ++i)
+    promise<void> both;
+    And<string,string>( string_ktor( new LoopN("Begin 1 ", 1) ),
+                        string_ktor( new LoopN("Begin 2 ", 2) ) ).andThen( [&both]( pair<string,string> r )
     {
-        cout << i << endl;
-        this_thread::sleep_for(chrono::seconds(1));
-    }
+        cout << "Finally 1 " << r.first << ", finally 2 " << r.second << endl;
+        both.set_value();
+    });
+
+    promise<void> first;
+    when_any( string_ktor( new Delayed<string>("slow", 200) ),
+              string_ktor( new Delayed<string>("fast", 100) ) ).andThen( [&first]( pair<size_t,string> r )
+    {
+        cout << "First is " << r.first << " with " << r.second << endl;
+        first.set_value();
+    });
+
+    // fan-out / fan-in over many async calls
+
+    vector< unique_ptr< Continuator<void,int> > > calls;
+    for( int i = 0; i < N_FANOUT; ++i )
+        calls.push_back( unique_ptr< Continuator<void,int> >( new Delayed<int>( i, 10 + i % 50 ) ) );
+
+    promise<void> all;
+    when_all( move(calls) ).andThen( [&all]( vector<int> r )
+    {
+        long sum = 0;
+        bool ordered = true;
+        for( size_t i = 0; i < r.size(); ++i )
+        {
+            sum += r[i];
+            ordered = ordered && r[i] == int(i);
+        }
+        cout << "Joined " << r.size() << " calls, sum " << sum << ( ordered ? ", in order" : ", OUT OF ORDER" ) << endl;
+        all.set_value();
+    });
+
+    first.get_future().wait();
+    all.get_future().wait();
+    both.get_future().wait();
+
+    cout << "> ending main" << endl;
 }
@@ -0,0 +1,76 @@
+#define _GLIBCXX_USE_NANOSLEEP 1
+
+// Many continuation chains waiting on time, none holding a thread while pending
+//
+// Each chain is a LoopN of Delayed steps: every step schedules a timer and returns,
+// the timer service resumes the chain when it expires.
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "Continuator.h"
+
+using namespace std;
+
+//-----------------------------------------------------------------------------
+
+#define N_CHAINS  20000
+#define N_STEPS       5
+#define STEP_MS      20
+
+//-----------------------------------------------------------------------------
+
+/// Sleeps n times, counting the steps in the value
+struct LoopN : Continuator<void, int>
+{
+    LoopN(int s, int n) : s_(s), n_(n) {}
+
+    void andThen(function<void(int)> k)
+    {
+        int n = n_;
+        Bind<void, int, Delayed<int> >( Delayed<int>( s_ + 1, STEP_MS ),
+        [n](int s) -> unique_ptr< Continuator<void,int> >
+        {
+            if (n > 1)
+                return unique_ptr< Continuator<void,int> >( new LoopN(s, n - 1) );
+            else
+                return unique_ptr< Continuator<void,int> >( new Return<void, int>(s) );
+        }).andThen(k);
+    }
+    int s_;
+    int n_;
+};
+
+//-----------------------------------------------------------------------------
+
+int main()
+{
+    cout << "> starting main" << endl;
+
+    atomic<int> done(0);
+    atomic<int> steps(0);
+
+    auto start = chrono::steady_clock::now();
+
+    for( int i = 0; i < N_CHAINS; ++i )
+        LoopN( 0, N_STEPS ).andThen( [&]( int s ) { steps += s; ++done; } );
+
+    cout << "> " << N_CHAINS << " chains started, " << TimerService::instance().size() << " timers pending" << endl;
+
+    while( done < N_CHAINS )
+        this_thread::sleep_for( chrono::milliseconds(1) );
+
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    cout << "> " << done << " chains of " << N_STEPS << " steps of " << STEP_MS << " ms"
+         << " completed in " << elapsed.count() << " s"
+         << ", " << steps << " steps, on 1 timer thread and "
+         << Executor::instance().tsize() << " executor threads" << endl;
+
+    cout << "> ending main" << endl;
+}
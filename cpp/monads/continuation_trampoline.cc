@@ -0,0 +1,143 @@
+#define _GLIBCXX_USE_NANOSLEEP 1
+
+// Long continuation chains in constant stack and without allocations
+//
+// The Bind of continuation_monad_2 nests a callback per step and allocates a new
+// LoopN and new std::function objects each time, so a synchronous chain of n steps
+// needs n stack frames and O(n) allocations.
+//
+// Here the same chains run on a Trampoline, see Trampoline.h: nothing nests, and
+// after the first steps a chain neither grows the stack nor allocates.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Continuator.h"
+#include "Trampoline.h"
+
+using namespace std;
+
+//-----------------------------------------------------------------------------
+
+#define N_SYNC_STEPS      10000000
+#define N_NESTED_STEPS       10000
+#define N_ASYNC_STEPS       200000
+
+//-----------------------------------------------------------------------------
+
+typedef Trampoline::Step<long> LStep;
+
+LStep loop_n( Trampoline& t, long s, intptr_t n );
+
+/// Rest of each step: continue the loop with one step less
+LStep loop_rest( Trampoline& t, long s, intptr_t n ) { return loop_n( t, s, n - 1 ); }
+
+/// Synchronous loop of n steps, each adding one
+LStep loop_n( Trampoline& t, long s, intptr_t n )
+{
+    if( n == 0 )
+        return t.ret( s );
+    return t.bind( t.ret( s + 1 ), &loop_rest, n );
+}
+
+/// Rest changing the value type: the mean increment over n steps
+Trampoline::Step<double> mean( Trampoline& t, long s, intptr_t n ) { return t.ret( double(s) / n ); }
+
+/// Async step adding one on the executor
+void post_step( Trampoline& t, intptr_t s ) { Executor::instance().post( [&t, s]() { t.resume<long>( s + 1 ); } ); }
+
+LStep async_loop_n( Trampoline& t, long s, intptr_t n );
+
+LStep async_rest( Trampoline& t, long s, intptr_t n ) { return async_loop_n( t, s, n - 1 ); }
+
+/// Loop of n async steps, each hopping to the executor
+LStep async_loop_n( Trampoline& t, long s, intptr_t n )
+{
+    if( n == 0 )
+        return t.ret( s );
+    return t.bind( t.async<long>( &post_step, s ), &async_rest, n );
+}
+
+//-----------------------------------------------------------------------------
+
+// the nested Bind of continuation_monad_2, for comparison
+
+struct LoopN : Continuator<void, long>
+{
+    LoopN(long s, int n) : s_(s), n_(n) {}
+
+    void andThen(function<void(long)> k)
+    {
+        int n = n_;
+        Bind< void, long, Return<void,long> >( Return<void,long>( s_ + 1 ),
+        [n](long s) -> unique_ptr<Continuator>
+        {
+            if (n > 1)
+                return unique_ptr<Continuator>( new LoopN(s, n - 1) );
+            else
+                return unique_ptr<Continuator>( new Return<void, long>(s) );
+        }).andThen(k);
+    }
+    long s_;
+    int  n_;
+};
+
+//-----------------------------------------------------------------------------
+
+typedef chrono::steady_clock clock_type;
+
+void report( const string& what, long steps, long result, clock_type::time_point start )
+{
+    chrono::duration<double> elapsed = clock_type::now() - start;
+    cout << "> " << what << ": " << steps << " steps -> " << result
+         << " in " << elapsed.count() << " s, " << long( steps / elapsed.count() ) << " steps/s" << endl;
+}
+
+int main()
+{
+    cout << "> starting main" << endl;
+
+    long result = 0;
+
+    // nested Binds, the stack grows with the chain
+
+    clock_type::time_point start = clock_type::now();
+    LoopN( 0, N_NESTED_STEPS ).andThen( [&result](long s) { result = s; } );
+    report( "nested bind      ", N_NESTED_STEPS, result, start );
+
+    // trampolined, synchronous
+
+    Trampoline t;
+
+    start = clock_type::now();
+    t.run( loop_n( t, 0, N_SYNC_STEPS ), [&result](long s) { result = s; } );
+    report( "trampoline sync  ", N_SYNC_STEPS, result, start );
+    cout << "> frames allocated " << t.allocated() << ", max stack of rests " << t.depth() << endl;
+
+    // trampolined, the last step turns the count into a double
+
+    double m = 0;
+    t.run( t.bind( loop_n( t, 0, N_SYNC_STEPS ), &mean, N_SYNC_STEPS ), [&m](double x) { m = x; } );
+    cout << "> mean increment per step " << m << ", frames allocated " << t.allocated() << endl;
+
+    // trampolined, each step resumed from the executor
+
+    Trampoline ta;
+    promise<long> done;
+
+    start = clock_type::now();
+    ta.run( async_loop_n( ta, 0, N_ASYNC_STEPS ), [&done](long s) { done.set_value(s); } );
+    result = done.get_future().get();
+    report( "trampoline async ", N_ASYNC_STEPS, result, start );
+    cout << "> frames allocated " << ta.allocated() << ", max stack of rests " << ta.depth() << endl;
+
+    cout << "> ending main" << endl;
+}
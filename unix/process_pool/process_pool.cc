@@ -0,0 +1,453 @@
+// Free and filled ring slots are counted with process-shared semaphores, and the
+// ring indices are guarded by a robust process-shared mutex, so a worker dying
+// while holding it does not deadlock the others.
+//
+// The semaphores are only wake up hints, the state lives under the mutex:
+// - the ring indices only grow, so the filled slots are tail - head
+// - a worker pops only if the ring is not empty, the parent pushes only if it is not full
+// - the completed jobs are counted in shared memory, not with the finished semaphore
+// So a count lost by a worker dying around a sem_wait or sem_post is reposted by
+// the parent after each death, and an extra count is only a spurious wake up.
+//
+// A worker writes a journal entry in its slot before changing the shared state
+// under the mutex. When the next owner gets EOWNERDEAD, it rolls back a pop
+// interrupted halfway, or completes a job completion interrupted halfway.
+
+#include "process_pool.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#define RING_SIZE 256
+
+//-----------------------------------------------------------------------------
+
+typedef struct
+{
+    long id;        // -1 tells the worker to exit
+    long arg;
+    int  attempts;  // nb of times it crashed a worker
+} job_t;
+
+enum op_t
+{
+    OP_NONE = 0,
+    OP_POP,         // taking a job from the ring
+    OP_DONE         // recording a completed job
+};
+
+typedef struct
+{
+    pid_t pid;
+    int   busy;     // 1 while executing job
+    job_t job;      // current job, reclaimed if the worker dies
+    long  done;     // nb jobs completed
+
+    int    op;              // op_t in progress under the lock
+    size_t saved_head;      // ring head before OP_POP
+    long   saved_done;      // done before OP_DONE
+    long   saved_completed; // completed before OP_DONE
+} worker_t;
+
+typedef struct
+{
+    pthread_mutex_t lock;       // guards ring indices, completed and worker slots
+    sem_t           slots;      // free ring slots, a hint
+    sem_t           items;      // filled ring slots, a hint
+    sem_t           finished;   // jobs completed, a hint
+
+    size_t   head;      // nb of jobs ever popped
+    size_t   tail;      // nb of jobs ever pushed
+    long     completed; // nb of jobs completed by the workers
+    job_t    ring[RING_SIZE];
+
+    // followed by worker_t workers[nb_workers], long results[max_jobs], int failed[max_jobs]
+} shared_t;
+
+struct pool_t
+{
+    shared_t*          sh;
+    size_t             length;          // of the mapping
+    int                nb_workers;
+    long               max_jobs;
+    int                max_attempts;
+    pool_handler       handler;
+
+    std::vector<job_t> retry;           // jobs reclaimed from dead workers
+    long               given_up;
+    int                crashes;
+    int                shutting_down;
+};
+
+//-----------------------------------------------------------------------------
+
+static worker_t* workers( const pool_t* p ) { return (worker_t*) (p->sh + 1); }
+static long*     results( const pool_t* p ) { return (long*) (workers(p) + p->nb_workers); }
+static int*      failed( const pool_t* p )  { return (int*) (results(p) + p->max_jobs); }
+
+/// Keeps the compiler from moving shared memory stores across it,
+/// so a process killed at any point leaves them in program order
+static void barrier()
+{
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+}
+
+/// Undoes or completes the operation of the worker that died holding the lock
+/// Only the lock owner has an operation in progress, so at most one is found
+static void repair( pool_t* p )
+{
+    shared_t* sh = p->sh;
+    for( int w = 0; w < p->nb_workers; ++w )
+    {
+        worker_t* me = &workers(p)[w];
+        switch( me->op )
+        {
+        case OP_POP:    // the job is still in its ring slot
+            sh->head = me->saved_head;
+            me->busy = 0;
+            break;
+        case OP_DONE:   // the result was stored before
+            me->busy = 0;
+            me->done = me->saved_done + 1;
+            sh->completed = me->saved_completed + 1;
+            break;
+        }
+        me->op = OP_NONE;
+    }
+}
+
+static void lock( pool_t* p )
+{
+    int rc = pthread_mutex_lock(&p->sh->lock);
+    if( rc == EOWNERDEAD ) // previous owner crashed inside a critical section
+    {
+        repair(p);
+        pthread_mutex_consistent(&p->sh->lock);
+    }
+    else if( rc != 0 )
+        errno = rc, perror("pthread_mutex_lock"), exit(EXIT_FAILURE);
+}
+
+static void unlock( pool_t* p )
+{
+    pthread_mutex_unlock(&p->sh->lock);
+}
+
+static void wait_sem( sem_t* s )
+{
+    while( sem_wait(s) == -1 )
+        if( errno != EINTR ) perror("sem_wait"), exit(EXIT_FAILURE);
+}
+
+/// @returns 0 if the semaphore was taken, -1 after waiting ms milliseconds
+static int timed_wait_sem( sem_t* s, long ms )
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += ms * 1000000;
+    ts.tv_sec  += ts.tv_nsec / 1000000000;
+    ts.tv_nsec %= 1000000000;
+
+    while( sem_timedwait(s, &ts) == -1 )
+    {
+        if( errno == ETIMEDOUT ) return -1;
+        if( errno != EINTR ) perror("sem_timedwait"), exit(EXIT_FAILURE);
+    }
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+
+/// The worker process mainline, never returns
+static void worker_function( pool_t* p, int w )
+{
+    shared_t* sh = p->sh;
+    worker_t* me = &workers(p)[w];
+
+    for(;;)
+    {
+        wait_sem(&sh->items);
+
+        lock(p);
+        if( sh->head == sh->tail ) // count reposted for a dead worker, the item was taken already
+        {
+            unlock(p);
+            continue;
+        }
+        me->saved_head = sh->head;
+        barrier();
+        me->op = OP_POP;
+        barrier();
+        job_t job = sh->ring[sh->head % RING_SIZE];
+        me->job  = job;
+        me->busy = (job.id >= 0);
+        ++sh->head;
+        barrier();
+        me->op = OP_NONE;
+        unlock(p);
+
+        sem_post(&sh->slots);
+
+        if( job.id < 0 )
+            exit(0);
+
+        results(p)[job.id] = p->handler(job.id, job.arg, job.attempts);
+
+        lock(p);
+        me->saved_done      = me->done;
+        me->saved_completed = sh->completed;
+        barrier();
+        me->op = OP_DONE;
+        barrier();
+        me->busy = 0;
+        me->done = me->saved_done + 1;
+        sh->completed = me->saved_completed + 1;
+        barrier();
+        me->op = OP_NONE;
+        unlock(p);
+
+        sem_post(&sh->finished);
+    }
+}
+
+static void spawn( pool_t* p, int w )
+{
+    fflush(stdout); // else the child inherits and repeats the buffered output
+    fflush(stderr);
+
+    pid_t pid = fork();
+    if( pid == -1 ) perror("fork"), exit(EXIT_FAILURE);
+    if( pid == 0 )
+        worker_function(p, w);   /* Does not return. */
+
+    workers(p)[w].pid = pid;
+}
+
+//-----------------------------------------------------------------------------
+
+/// Posts s until its value reaches n
+static void repost( sem_t* s, long n )
+{
+    int v = 0;
+    if( sem_getvalue(s, &v) == -1 ) perror("sem_getvalue"), exit(EXIT_FAILURE);
+    for( long lost = n - v; lost > 0; --lost )
+        sem_post(s);
+}
+
+/// Reposts the counts lost by workers that died around a sem_wait or sem_post
+/// Live workers between a sem_wait and the lock, or between the unlock and a sem_post,
+/// also make a semaphore look low, which only costs a spurious wake up
+static void recount( pool_t* p )
+{
+    shared_t* sh = p->sh;
+    lock(p);
+    long filled = long(sh->tail - sh->head);
+    repost(&sh->items, filled);
+    repost(&sh->slots, RING_SIZE - filled);
+    unlock(p);
+    sem_post(&sh->finished);
+}
+
+/// Reaps dead workers, reclaims their jobs into retry and respawns them
+static void reap( pool_t* p )
+{
+    int status;
+    pid_t pid;
+    int died = 0;
+    while( (pid = waitpid(-1, &status, WNOHANG)) > 0 )
+    {
+        int w = 0;
+        while( w < p->nb_workers && workers(p)[w].pid != pid )
+            ++w;
+        if( w == p->nb_workers )
+            continue;
+
+        lock(p);
+        int   busy = workers(p)[w].busy;
+        job_t job  = workers(p)[w].job;
+        workers(p)[w].busy = 0;
+        workers(p)[w].pid  = 0;
+        unlock(p);
+
+        if( WIFEXITED(status) && WEXITSTATUS(status) == 0 && !busy )
+            continue; // normal exit at shutdown
+
+        ++died;
+        ++p->crashes;
+        fprintf(stderr, "worker %d (pid %d) died with %s %d on job %ld\n", w, (int) pid,
+                WIFSIGNALED(status) ? "signal" : "status",
+                WIFSIGNALED(status) ? WTERMSIG(status) : WEXITSTATUS(status),
+                busy ? job.id : -1L);
+
+        if( busy )
+        {
+            if( ++job.attempts >= p->max_attempts )
+            {
+                failed(p)[job.id] = 1;
+                ++p->given_up;
+            }
+            else
+                p->retry.push_back(job);
+        }
+
+        if( !p->shutting_down )
+            spawn(p, w);
+    }
+
+    if( died )
+        recount(p);
+}
+
+/// Puts a job in the ring, reaping dead workers while the ring is full
+static void push( pool_t* p, const job_t& job )
+{
+    shared_t* sh = p->sh;
+    for(;;)
+    {
+        while( timed_wait_sem(&sh->slots, 10) == -1 )
+            reap(p);
+
+        lock(p);
+        if( sh->tail - sh->head < RING_SIZE )
+            break;
+        unlock(p); // count reposted for a dead worker, the slot was not freed
+    }
+    sh->ring[sh->tail % RING_SIZE] = job;
+    ++sh->tail;
+    unlock(p);
+
+    sem_post(&sh->items);
+}
+
+static void push_retries( pool_t* p )
+{
+    while( !p->retry.empty() )
+    {
+        job_t job = p->retry.back();
+        p->retry.pop_back();
+        push(p, job);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+pool_t* pool_create( int nb_workers, long max_jobs, int max_attempts, pool_handler h )
+{
+    pool_t* p = new pool_t();
+    p->nb_workers    = nb_workers;
+    p->max_jobs      = max_jobs;
+    p->max_attempts  = max_attempts;
+    p->handler       = h;
+    p->given_up      = 0;
+    p->crashes       = 0;
+    p->shutting_down = 0;
+    p->length        = sizeof(shared_t) + nb_workers * sizeof(worker_t) + max_jobs * (sizeof(long) + sizeof(int));
+
+    p->sh = (shared_t*) mmap(0, p->length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if( p->sh == MAP_FAILED ) perror("mmap"), exit(EXIT_FAILURE);
+
+    shared_t* sh = p->sh;
+
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&sh->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    if( sem_init(&sh->slots,    1, RING_SIZE) == -1 ) perror("sem_init"), exit(EXIT_FAILURE);
+    if( sem_init(&sh->items,    1, 0)         == -1 ) perror("sem_init"), exit(EXIT_FAILURE);
+    if( sem_init(&sh->finished, 1, 0)         == -1 ) perror("sem_init"), exit(EXIT_FAILURE);
+
+    for( int w = 0; w < nb_workers; ++w )
+        spawn(p, w);
+
+    return p;
+}
+
+void pool_submit( pool_t* p, long id, long arg )
+{
+    job_t job = { id, arg, 0 };
+    push(p, job);
+    push_retries(p);
+}
+
+long pool_finished( pool_t* p )
+{
+    while( sem_trywait(&p->sh->finished) == 0 ) // keep the hint from piling up
+        ;
+
+    lock(p);
+    long completed = p->sh->completed;
+    unlock(p);
+
+    return completed + p->given_up;
+}
+
+void pool_wait( pool_t* p, long nb )
+{
+    while( pool_finished(p) < nb )
+    {
+        if( timed_wait_sem(&p->sh->finished, 10) == -1 )
+        {
+            reap(p);
+            push_retries(p);
+        }
+    }
+}
+
+int pool_result( const pool_t* p, long id, long* r )
+{
+    if( failed(p)[id] )
+        return -1;
+    *r = results(p)[id];
+    return 0;
+}
+
+int pool_crashes( const pool_t* p )
+{
+    return p->crashes;
+}
+
+long pool_done( const pool_t* p, int w )
+{
+    return workers(p)[w].done;
+}
+
+void pool_destroy( pool_t* p )
+{
+    // tell the workers to exit and wait for them
+
+    p->shutting_down = 1;
+    for( int w = 0; w < p->nb_workers; ++w )
+    {
+        job_t stop = { -1, 0, 0 };
+        push(p, stop);
+    }
+    for( int w = 0; w < p->nb_workers; ++w )
+        while( workers(p)[w].pid )
+        {
+            reap(p);
+            usleep(1000);
+        }
+
+    shared_t* sh = p->sh;
+    sem_destroy(&sh->slots);
+    sem_destroy(&sh->items);
+    sem_destroy(&sh->finished);
+    pthread_mutex_destroy(&sh->lock);
+
+    if( munmap(sh, p->length) == -1 ) perror("munmap"), exit(EXIT_FAILURE);
+
+    delete p;
+}
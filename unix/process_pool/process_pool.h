@@ -0,0 +1,49 @@
+#ifndef process_pool_h
+#define process_pool_h
+
+// Pre-forked pool of worker processes, fed through a ring in shared memory
+//
+// The parent forks the workers once, then hands them jobs through a ring buffer
+// living in an anonymous MAP_SHARED mapping, so no pipe or socket copies are involved.
+// Jobs are numbered by the caller from 0 to max_jobs - 1, and each one stores its
+// result in a slot of the shared memory the parent reads back with pool_result.
+//
+// When a worker crashes, the parent reaps it, requeues the job it was executing
+// (or gives up after max_attempts) and forks a replacement.
+//
+// All the functions are called from the parent process only.
+
+typedef struct pool_t pool_t;
+
+/// Job handler, executed in a worker process
+/// It may crash its process, the job is then retried with attempts incremented
+/// @returns the result of job id
+typedef long (*pool_handler)( long id, long arg, int attempts );
+
+/// Maps the shared memory and forks the workers
+/// @param max_jobs is the nb of result slots, job ids must be below it
+/// @param max_attempts is the nb of crashes after which a job is given up
+pool_t* pool_create( int nb_workers, long max_jobs, int max_attempts, pool_handler h );
+
+/// Queues a job, blocking while the ring is full
+void pool_submit( pool_t* p, long id, long arg );
+
+/// @returns the nb of jobs completed or given up so far, never blocks
+long pool_finished( pool_t* p );
+
+/// Waits until nb jobs are completed or given up, requeuing the jobs of crashed workers
+void pool_wait( pool_t* p, long nb );
+
+/// @returns 0 and sets r if job id completed, -1 if it was given up
+int pool_result( const pool_t* p, long id, long* r );
+
+/// @returns the nb of workers that crashed
+int pool_crashes( const pool_t* p );
+
+/// @returns the nb of jobs completed by worker w
+long pool_done( const pool_t* p, int w );
+
+/// Stops the workers, waits for them and unmaps the shared memory
+void pool_destroy( pool_t* p );
+
+#endif
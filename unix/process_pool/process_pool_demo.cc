@@ -0,0 +1,87 @@
+// Runs faulty jobs through the pre-forked process pool
+//
+// Some jobs crash their worker on the first attempt and one crashes it every time,
+// every other job must come back with the correct result.
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <sys/time.h>
+
+#include "process_pool.h"
+
+#define N_WORKERS      4
+#define N_JOBS    200000
+#define MAX_ATTEMPTS   2
+
+#define TRANSIENT_EVERY 50000 // these jobs crash their worker on the first attempt
+#define POISON_JOB      12345 // this job always crashes its worker
+
+//-----------------------------------------------------------------------------
+
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static long expected( long arg )
+{
+    long r = 0;
+    for( long i = 0; i < arg; ++i )
+        r += i * i;
+    return r;
+}
+
+/// The job handler, possibly faulty
+static long handle( long id, long arg, int attempts )
+{
+    if( id == POISON_JOB )
+        abort();
+
+    if( id % TRANSIENT_EVERY == 7 && attempts == 0 )
+        abort();
+
+    return expected(arg);
+}
+
+//-----------------------------------------------------------------------------
+
+int main(void)
+{
+    printf("> starting main\n");
+
+    pool_t* pool = pool_create(N_WORKERS, N_JOBS, MAX_ATTEMPTS, handle);
+
+    double start = now();
+
+    for( long i = 0; i < N_JOBS; ++i )
+        pool_submit(pool, i, i % 100);
+
+    pool_wait(pool, N_JOBS);
+
+    double elapsed = now() - start;
+
+    long nb_failed = 0;
+    long nb_wrong  = 0;
+    for( long i = 0; i < N_JOBS; ++i )
+    {
+        long r;
+        if( pool_result(pool, i, &r) == -1 )
+            ++nb_failed;
+        else if( r != expected(i % 100) )
+            ++nb_wrong;
+    }
+
+    printf("> %d jobs in %f s, %.0f jobs/s\n", N_JOBS, elapsed, N_JOBS / elapsed);
+    printf("> worker crashes %d, jobs given up %ld, wrong results %ld\n", pool_crashes(pool), nb_failed, nb_wrong);
+    for( int w = 0; w < N_WORKERS; ++w )
+        printf("> worker %d completed %ld jobs\n", w, pool_done(pool, w));
+
+    pool_destroy(pool);
+
+    printf("> ending main\n");
+
+    return nb_wrong ? EXIT_FAILURE : 0;
+}